@@ -2,6 +2,18 @@
 #include "../Logger/Logger.h"
 #include <SDL2/SDL_image.h>
 
+// imgui_draw.cpp keeps its copy of the packer static, this file gets its own
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+#include <imgui/imstb_rectpack.h>
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
 AssetStore::AssetStore() {
     Logger::Log("AssetStore Constructor called!");
 }
@@ -18,6 +30,22 @@ void AssetStore::ClearAssets() {
 
     textures.clear();
 
+    for (auto page:atlasPages) {
+        SDL_DestroyTexture(page);
+    }
+
+    atlasPages.clear();
+
+    for (auto surface:surfaces) {
+        SDL_FreeSurface(surface.second);
+    }
+
+    surfaces.clear();
+    textureRegions.clear();
+
+    // The cached text textures point to the fonts closed below
+    textCache.Clear();
+
     for (auto font:fonts) {
         TTF_CloseFont(font.second);
     }
@@ -28,15 +56,104 @@ void AssetStore::ClearAssets() {
 void AssetStore::AddTexture(SDL_Renderer* renderer, const std::string& assetId, const std::string& filePath) {
     SDL_Surface* surface = IMG_Load(filePath.c_str());
     SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_FreeSurface(surface);
 
     textures.emplace(assetId, texture);
 
+    // The pixels are kept until the atlas is built
+    if (surface) {
+        textureRegions[assetId] = TextureRegion { texture, {0, 0, surface->w, surface->h} };
+        surfaces.emplace(assetId, surface);
+    }
+
     Logger::Log("New texture added to the AssetStore with id = " + assetId);
 }
 
 SDL_Texture* AssetStore::GetTexture(const std::string& assetId) {
-    return textures[assetId];
+    return textureRegions[assetId].texture;
+}
+
+const SDL_Rect& AssetStore::GetTextureRect(const std::string& assetId) {
+    return textureRegions[assetId].rect;
+}
+
+void AssetStore::BuildAtlas(SDL_Renderer* renderer) {
+    std::vector<std::string> assetIds;
+    std::vector<stbrp_rect> rects;
+
+    for (auto surface:surfaces) {
+        const int width = surface.second->w + 2 * ATLAS_PADDING;
+        const int height = surface.second->h + 2 * ATLAS_PADDING;
+
+        if (width <= ATLAS_PAGE_SIZE && height <= ATLAS_PAGE_SIZE) {
+            stbrp_rect rect = {};
+            rect.id = assetIds.size();
+            rect.w = width;
+            rect.h = height;
+            assetIds.push_back(surface.first);
+            rects.push_back(rect);
+        }
+    }
+
+    std::vector<stbrp_node> nodes(ATLAS_PAGE_SIZE);
+
+    // Each page takes what fits, the rest goes to the next one
+    while (!rects.empty()) {
+        stbrp_context context;
+        stbrp_init_target(&context, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, nodes.data(), nodes.size());
+        stbrp_pack_rects(&context, rects.data(), rects.size());
+
+        std::vector<stbrp_rect> unpackedRects;
+        for (const auto& rect : rects) {
+            if (!rect.was_packed) {
+                unpackedRects.push_back(rect);
+            }
+        }
+
+        // Nothing fits in an empty page, these images keep their own texture
+        if (unpackedRects.size() == rects.size()) {
+            break;
+        }
+
+        SDL_Surface* pageSurface = SDL_CreateRGBSurfaceWithFormat(0, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, 32, SDL_PIXELFORMAT_RGBA32);
+
+        for (const auto& rect : rects) {
+            if (rect.was_packed) {
+                const std::string& assetId = assetIds[rect.id];
+                SDL_Surface* surface = surfaces[assetId];
+                SDL_Rect dstRect = {rect.x + ATLAS_PADDING, rect.y + ATLAS_PADDING, surface->w, surface->h};
+
+                // Copy the pixels as they are, alpha included
+                SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+                SDL_BlitSurface(surface, NULL, pageSurface, &dstRect);
+
+                textureRegions[assetId].rect = dstRect;
+            }
+        }
+
+        SDL_Texture* page = SDL_CreateTextureFromSurface(renderer, pageSurface);
+        SDL_SetTextureBlendMode(page, SDL_BLENDMODE_BLEND);
+        SDL_FreeSurface(pageSurface);
+        atlasPages.push_back(page);
+
+        // The packed images no longer need their own texture
+        for (const auto& rect : rects) {
+            if (rect.was_packed) {
+                const std::string& assetId = assetIds[rect.id];
+                SDL_DestroyTexture(textures[assetId]);
+                textures.erase(assetId);
+                textureRegions[assetId].texture = page;
+            }
+        }
+
+        Logger::Log("Atlas page " + std::to_string(atlasPages.size()) + " packed " + std::to_string(rects.size() - unpackedRects.size()) + " images");
+        rects.swap(unpackedRects);
+    }
+
+    for (auto surface:surfaces) {
+        SDL_FreeSurface(surface.second);
+    }
+
+    surfaces.clear();
 }
 
 void AssetStore::AddFont(const std::string& assetId, const std::string& filePath, int fontSize) {
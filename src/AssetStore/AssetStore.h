@@ -3,13 +3,38 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#include "TextCache.h"
+
+// Size of the atlas textures the images are packed into, images that don't fit keep their own texture
+const int ATLAS_PAGE_SIZE = 2048;
+
+// Empty pixels around each image in the atlas, so filtering never samples the neighbour image
+const int ATLAS_PADDING = 1;
+
+// Where the pixels of an image are: its own texture, or a rect of an atlas page
+struct TextureRegion {
+    SDL_Texture* texture = nullptr;
+    SDL_Rect rect = {0, 0, 0, 0};
+};
 
 class AssetStore {
 private:
     std::map<std::string, SDL_Texture*> textures;
     std::map<std::string, TTF_Font*> fonts;
+
+    // Every image added, pointing to its own texture until the atlas is built
+    std::map<std::string, TextureRegion> textureRegions;
+
+    // Pixels of the images that are not packed yet
+    std::map<std::string, SDL_Surface*> surfaces;
+
+    std::vector<SDL_Texture*> atlasPages;
+
+    // Rendered text, keyed by the font pointers of this store
+    TextCache textCache;
     
 public:
     AssetStore();
@@ -20,9 +45,19 @@ public:
     void AddTexture(SDL_Renderer* renderer, const std::string& assetId, const std::string& filePath);
     SDL_Texture* GetTexture(const std::string& assetId);
 
+    // Rect of the image inside the texture returned by GetTexture, sprite source rects are offset by it
+    const SDL_Rect& GetTextureRect(const std::string& assetId);
+
+    // Packs the images added so far into as few atlas pages as possible, so sprites of different images
+    // share a texture and can be drawn together. Call it after loading the images of a level
+    void BuildAtlas(SDL_Renderer* renderer);
+    int GetNumAtlasPages() const { return atlasPages.size(); }
+
     void AddFont(const std::string& assetId, const std::string& filePath, int fontSize);
     TTF_Font* GetFont(const std::string& assetId);
 
+    TextCache& GetTextCache() { return textCache; }
+
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,194 @@
+#include "TextCache.h"
+#include <algorithm>
+
+TextCache::~TextCache() {
+    Clear();
+}
+
+std::uint64_t TextCache::GetKey(TTF_Font* font, const std::string& text, SDL_Color color) {
+    // FNV-1a over the font pointer, the color and the characters
+    std::uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](std::uint64_t value) {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    };
+
+    add(reinterpret_cast<std::uintptr_t>(font));
+    add((std::uint64_t(color.r) << 24) | (std::uint64_t(color.g) << 16) | (std::uint64_t(color.b) << 8) | color.a);
+    for (const char ch : text) {
+        add(static_cast<unsigned char>(ch));
+    }
+
+    return hash;
+}
+
+void TextCache::SetBudget(std::size_t budget) {
+    this->budget = budget;
+    EvictOverBudget();
+}
+
+void TextCache::EvictOverBudget() {
+    // The most recent label stays even if it is bigger than the whole budget, it is being drawn
+    while (stats.numBytes > budget && labels.size() > 1) {
+        const Label& label = labels.back();
+
+        SDL_DestroyTexture(label.texture);
+        stats.numBytes -= label.numBytes;
+        stats.numLabels--;
+        stats.numEvictions++;
+
+        labelPerKey.erase(label.key);
+        labels.pop_back();
+    }
+}
+
+SDL_Texture* TextCache::GetLabel(SDL_Renderer* renderer, TTF_Font* font, const std::string& text, SDL_Color color, int& width, int& height) {
+    const std::uint64_t key = GetKey(font, text, color);
+    auto found = labelPerKey.find(key);
+
+    if (found != labelPerKey.end()) {
+        Label& label = *found->second;
+
+        if (label.font == font && label.text == text && label.color.r == color.r && label.color.g == color.g &&
+            label.color.b == color.b && label.color.a == color.a) {
+            labels.splice(labels.begin(), labels, found->second);
+            stats.numHits++;
+
+            width = label.width;
+            height = label.height;
+            return label.texture;
+        }
+
+        // Another label with the same hash, the new one takes its place
+        SDL_DestroyTexture(label.texture);
+        stats.numBytes -= label.numBytes;
+        stats.numLabels--;
+        labels.erase(found->second);
+        labelPerKey.erase(found);
+    }
+
+    stats.numMisses++;
+    width = 0;
+    height = 0;
+
+    SDL_Surface* surface = TTF_RenderText_Blended(font, text.c_str(), color);
+    if (!surface) {
+        return nullptr;
+    }
+
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    width = surface->w;
+    height = surface->h;
+    SDL_FreeSurface(surface);
+
+    const std::size_t numBytes = std::size_t(width) * height * 4;
+    labels.push_front(Label { key, font, text, color, texture, width, height, numBytes });
+    labelPerKey[key] = labels.begin();
+    stats.numBytes += numBytes;
+    stats.numLabels++;
+
+    EvictOverBudget();
+
+    return texture;
+}
+
+TextCache::GlyphAtlas& TextCache::GetGlyphAtlas(SDL_Renderer* renderer, TTF_Font* font) {
+    auto found = glyphAtlases.find(font);
+    if (found != glyphAtlases.end()) {
+        return found->second;
+    }
+
+    GlyphAtlas& atlas = glyphAtlases[font];
+    atlas.glyphs.resize(GLYPH_ATLAS_LAST_CHAR - GLYPH_ATLAS_FIRST_CHAR + 1, Glyph { {0, 0, 0, 0}, 0 });
+
+    // Glyphs are rendered white, the color is applied with the texture color mod when they are drawn
+    const SDL_Color white = {255, 255, 255, 255};
+    std::vector<SDL_Surface*> surfaces(atlas.glyphs.size(), nullptr);
+    int penX = 0, penY = 0, rowHeight = 0;
+
+    for (Uint16 ch = GLYPH_ATLAS_FIRST_CHAR; ch <= GLYPH_ATLAS_LAST_CHAR; ch++) {
+        Glyph& glyph = atlas.glyphs[ch - GLYPH_ATLAS_FIRST_CHAR];
+        int minX, maxX, minY, maxY;
+        TTF_GlyphMetrics(font, ch, &minX, &maxX, &minY, &maxY, &glyph.advance);
+
+        SDL_Surface* surface = TTF_RenderGlyph_Blended(font, ch, white);
+        if (!surface) {
+            continue;
+        }
+        surfaces[ch - GLYPH_ATLAS_FIRST_CHAR] = surface;
+
+        if (penX + surface->w > GLYPH_ATLAS_WIDTH) {
+            penX = 0;
+            penY += rowHeight;
+            rowHeight = 0;
+        }
+
+        glyph.srcRect = {penX, penY, surface->w, surface->h};
+        penX += surface->w;
+        rowHeight = std::max(rowHeight, surface->h);
+    }
+
+    const int atlasHeight = penY + rowHeight;
+    if (atlasHeight > 0) {
+        SDL_Surface* atlasSurface = SDL_CreateRGBSurfaceWithFormat(0, GLYPH_ATLAS_WIDTH, atlasHeight, 32, SDL_PIXELFORMAT_RGBA32);
+
+        for (std::size_t i = 0; i < surfaces.size(); i++) {
+            if (surfaces[i]) {
+                SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+                SDL_BlitSurface(surfaces[i], NULL, atlasSurface, &atlas.glyphs[i].srcRect);
+            }
+        }
+
+        atlas.texture = SDL_CreateTextureFromSurface(renderer, atlasSurface);
+        SDL_SetTextureBlendMode(atlas.texture, SDL_BLENDMODE_BLEND);
+        SDL_FreeSurface(atlasSurface);
+    }
+
+    for (auto surface : surfaces) {
+        if (surface) {
+            SDL_FreeSurface(surface);
+        }
+    }
+
+    return atlas;
+}
+
+void TextCache::DrawGlyphs(SDL_Renderer* renderer, TTF_Font* font, const std::string& text, SDL_Color color, int x, int y) {
+    GlyphAtlas& atlas = GetGlyphAtlas(renderer, font);
+    if (!atlas.texture) {
+        return;
+    }
+
+    SDL_SetTextureColorMod(atlas.texture, color.r, color.g, color.b);
+
+    for (const char ch : text) {
+        const Uint16 code = static_cast<unsigned char>(ch);
+        if (code < GLYPH_ATLAS_FIRST_CHAR || code > GLYPH_ATLAS_LAST_CHAR) {
+            continue;
+        }
+
+        const Glyph& glyph = atlas.glyphs[code - GLYPH_ATLAS_FIRST_CHAR];
+        SDL_Rect dstRect = {x, y, glyph.srcRect.w, glyph.srcRect.h};
+        SDL_RenderCopy(renderer, atlas.texture, &glyph.srcRect, &dstRect);
+        x += glyph.advance;
+    }
+}
+
+void TextCache::Clear() {
+    for (auto& label : labels) {
+        SDL_DestroyTexture(label.texture);
+    }
+
+    labels.clear();
+    labelPerKey.clear();
+    stats.numLabels = 0;
+    stats.numBytes = 0;
+
+    for (auto& atlas : glyphAtlases) {
+        if (atlas.second.texture) {
+            SDL_DestroyTexture(atlas.second.texture);
+        }
+    }
+
+    glyphAtlases.clear();
+}
@@ -0,0 +1,90 @@
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+// Bytes of label textures the cache keeps before it starts dropping the least recently drawn ones
+const std::size_t TEXT_CACHE_DEFAULT_BUDGET = 4 * 1024 * 1024;
+
+// Characters baked into the glyph atlas of each font, printable ASCII
+const Uint16 GLYPH_ATLAS_FIRST_CHAR = 32;
+const Uint16 GLYPH_ATLAS_LAST_CHAR = 126;
+
+// Width of the glyph atlas rows, the height grows with the number of rows
+const int GLYPH_ATLAS_WIDTH = 512;
+
+// Counters since the cache was created
+struct TextCacheStats {
+    int numLabels = 0;
+    std::size_t numBytes = 0;
+    int numHits = 0;
+    int numMisses = 0;
+    int numEvictions = 0;
+};
+
+// Keeps the textures of rendered text so a label that doesn't change is rasterized once.
+// Whole labels are cached by font, text and color with an LRU under a byte budget; strings that change
+// often (counters, health values) are drawn glyph by glyph from a per font atlas tinted with the color.
+class TextCache {
+private:
+    struct Label {
+        std::uint64_t key;
+        TTF_Font* font;
+        std::string text;
+        SDL_Color color;
+        SDL_Texture* texture;
+        int width;
+        int height;
+        std::size_t numBytes;
+    };
+
+    struct Glyph {
+        SDL_Rect srcRect;
+        int advance;
+    };
+
+    struct GlyphAtlas {
+        SDL_Texture* texture = nullptr;
+        std::vector<Glyph> glyphs;
+    };
+
+    // Most recently drawn label first
+    std::list<Label> labels;
+    std::unordered_map<std::uint64_t, std::list<Label>::iterator> labelPerKey;
+    std::unordered_map<TTF_Font*, GlyphAtlas> glyphAtlases;
+    std::size_t budget = TEXT_CACHE_DEFAULT_BUDGET;
+    TextCacheStats stats;
+
+    static std::uint64_t GetKey(TTF_Font* font, const std::string& text, SDL_Color color);
+    void EvictOverBudget();
+    GlyphAtlas& GetGlyphAtlas(SDL_Renderer* renderer, TTF_Font* font);
+
+public:
+    TextCache() = default;
+    ~TextCache();
+
+    TextCache(const TextCache&) = delete;
+    TextCache& operator=(const TextCache&) = delete;
+
+    void SetBudget(std::size_t budget);
+    const TextCacheStats& GetStats() const { return stats; }
+
+    // Returns the texture of the label, rendering it only when it is not cached. The texture is owned by
+    // the cache and stays valid until the next call
+    SDL_Texture* GetLabel(SDL_Renderer* renderer, TTF_Font* font, const std::string& text, SDL_Color color, int& width, int& height);
+
+    // Draws the text with its top left corner at x, y from the glyph atlas of the font, nothing is rendered
+    // by SDL_ttf after the first call for a font
+    void DrawGlyphs(SDL_Renderer* renderer, TTF_Font* font, const std::string& text, SDL_Color color, int x, int y);
+
+    // Destroys every texture, it has to be called before the fonts are closed
+    void Clear();
+};
+
+#endif
@@ -2,16 +2,34 @@
 #define BOXCOLLIDERCOMPONENT_H
 
 #include <glm/glm.hpp>
+#include <cstdint>
+
+// Collision layers, a collider belongs to one layer and its mask has the layers it collides with
+enum CollisionLayer {
+    LAYER_DEFAULT = 1 << 0,
+    LAYER_TILE = 1 << 1, // solid tiles of the tilemap, handled by the collision system tile bitmap
+    LAYER_PLAYER = 1 << 2,
+    LAYER_ENEMY = 1 << 3,
+    LAYER_PLAYER_PROJECTILE = 1 << 4,
+    LAYER_ENEMY_PROJECTILE = 1 << 5
+};
+
+const unsigned int MAX_COLLISION_LAYERS = 32;
+const std::uint32_t LAYER_MASK_ALL = ~0u;
 
 struct BoxColliderComponent {
     int width;
     int height;
     glm::vec2 offset;
+    std::uint32_t layer;
+    std::uint32_t mask;
 
-    BoxColliderComponent(int width = 0, int height = 0, glm::vec2 offset = glm::vec2(0)) {
+    BoxColliderComponent(int width = 0, int height = 0, glm::vec2 offset = glm::vec2(0), std::uint32_t layer = LAYER_DEFAULT, std::uint32_t mask = LAYER_MASK_ALL) {
         this->width = width;
         this->height = height;
         this->offset = offset;
+        this->layer = layer;
+        this->mask = mask;
     }
 };
-#endif
\ No newline at end of file
+#endif
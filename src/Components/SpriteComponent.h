@@ -8,6 +8,7 @@ struct SpriteComponent {
     std::string assetId;
     int width;
     int height;
+    // Read when the sprite is added to the RenderSystem, change it later with RenderSystem::SetZIndex
     int zIndex;
     bool isFixed;
     SDL_Rect srcRect;
@@ -0,0 +1,27 @@
+#ifndef TILEMAPCOMPONENT_H
+#define TILEMAPCOMPONENT_H
+
+#include <string>
+#include <vector>
+#include <SDL2/SDL.h>
+
+// A whole grid of tiles from one tileset, drawn by the RenderTilemapSystem instead of one sprite per tile
+struct TilemapComponent {
+    std::string assetId;
+    int tileSize;
+    double tileScale;
+    int numCols;
+    int numRows;
+    std::vector<SDL_Point> tiles; // position of each tile in the tileset, row by row
+
+    TilemapComponent(std::string assetId = "", int tileSize = 0, double tileScale = 1.0, int numCols = 0, int numRows = 0, std::vector<SDL_Point> tiles = {}) {
+        this->assetId = assetId;
+        this->tileSize = tileSize;
+        this->tileScale = tileScale;
+        this->numCols = numCols;
+        this->numRows = numRows;
+        this->tiles = tiles;
+    }
+};
+
+#endif
@@ -1,28 +1,311 @@
 #include "ECS.h"
+#include "../JobSystem/JobSystem.h"
 
 int IComponent::nextId = 0;
 
 void System::AddEntity(Entity entity) {
-    entities.push_back(entity);
+    const auto entityId = entity.GetId();
+
+    if (HasEntity(entity)) {
+        return;
+    }
+
+    if (static_cast<std::size_t>(entityId) >= entityIdToIndex.size()) {
+        entityIdToIndex.resize(entityId + 1, -1);
+    }
+
+    registry = entity.registry;
+    entityIdToIndex[entityId] = entityIds.size();
+    entityIds.push_back(entityId);
+
+    OnEntityAdded(entity);
 }
 
 void System::RemoveEntity(Entity entity) {
-    entities.erase(std::remove_if(
-        entities.begin(), 
-        entities.end(),
-        [entity](const Entity& other) { return entity == other; }), 
-        entities.end());
+    if (!HasEntity(entity)) {
+        return;
+    }
+
+    // Swap the last member into the removed slot to keep the membership packed
+    const int indexOfRemoved = entityIdToIndex[entity.GetId()];
+    const int entityIdOfLast = entityIds.back();
+
+    entityIds[indexOfRemoved] = entityIdOfLast;
+    entityIdToIndex[entityIdOfLast] = indexOfRemoved;
+
+    entityIdToIndex[entity.GetId()] = -1;
+    entityIds.pop_back();
+
+    OnEntityRemoved(entity);
 }
 
-std::vector<Entity> System::GetSystemEntities() const {
-    return entities;
+bool System::HasEntity(Entity entity) const {
+    const auto entityId = entity.GetId();
+    return static_cast<std::size_t>(entityId) < entityIdToIndex.size() && entityIdToIndex[entityId] != -1;
+}
+
+EntityRange System::GetSystemEntities() const {
+    return EntityRange(entityIds.data(), entityIds.data() + entityIds.size(), registry);
+}
+
+const std::vector<int>& System::GetSystemEntityIds() const {
+    return entityIds;
 }
 
 const Signature& System::GetComponentSignature() const {
     return componentSignature;
 }
 
-Registry::Registry() {
+const Signature& System::GetReadSignature() const {
+    return readSignature;
+}
+
+const Signature& System::GetWriteSignature() const {
+    return writeSignature;
+}
+
+bool System::IsExclusive() const {
+    return isExclusive;
+}
+
+void System::RequireExclusiveAccess() {
+    isExclusive = true;
+}
+
+Archetype::Archetype(const Signature& signature, const std::vector<ComponentInfo>& allComponentInfos) : signature(signature) {
+    columnOffsets.fill(0);
+    columnStrides.fill(0);
+
+    for (std::size_t componentId = 0; componentId < MAX_COMPONENTS; componentId++) {
+        if (signature.test(componentId)) {
+            componentIds.push_back(componentId);
+            componentInfos.push_back(allComponentInfos[componentId]);
+            columnStrides[componentId] = allComponentInfos[componentId].size;
+        }
+    }
+
+    // Fit as many rows as possible in a chunk, but always at least one even for very large components
+    std::size_t bytesPerRow = sizeof(int);
+    for (const auto& info : componentInfos) {
+        bytesPerRow += info.size;
+    }
+
+    chunkCapacity = std::max<std::size_t>(1, ARCHETYPE_CHUNK_SIZE / bytesPerRow);
+    while (chunkCapacity > 1 && ComputeChunkLayout(chunkCapacity) > ARCHETYPE_CHUNK_SIZE) {
+        chunkCapacity--;
+    }
+
+    chunkBytes = std::max(ARCHETYPE_CHUNK_SIZE, ComputeChunkLayout(chunkCapacity));
+}
+
+Archetype::~Archetype() {
+    for (std::size_t row = 0; row < size; row++) {
+        for (std::size_t i = 0; i < componentIds.size(); i++) {
+            componentInfos[i].destroy(GetComponent(row, componentIds[i]));
+        }
+    }
+}
+
+std::size_t Archetype::ComputeChunkLayout(std::size_t capacity) {
+    // The entity id column goes first, then each component column aligned to its type
+    std::size_t offset = capacity * sizeof(int);
+
+    for (std::size_t i = 0; i < componentIds.size(); i++) {
+        const std::size_t alignment = componentInfos[i].alignment;
+        offset = (offset + alignment - 1) / alignment * alignment;
+        columnOffsets[componentIds[i]] = offset;
+        offset += capacity * componentInfos[i].size;
+    }
+
+    return offset;
+}
+
+std::size_t Archetype::GetChunkSize(std::size_t chunk) const {
+    return std::min(chunkCapacity, size - chunk * chunkCapacity);
+}
+
+const int* Archetype::GetEntityIds(std::size_t chunk) const {
+    return reinterpret_cast<const int*>(chunks[chunk].get());
+}
+
+int Archetype::GetEntityId(std::size_t row) const {
+    return GetEntityIds(row / chunkCapacity)[row % chunkCapacity];
+}
+
+void* Archetype::GetComponent(std::size_t row, int componentId) const {
+    // Columns the archetype lacks have offset 0, which is the entity id column
+    assert(HasComponent(componentId) && "Archetype has no column for this component");
+
+    const std::size_t chunk = row / chunkCapacity;
+    const std::size_t slot = row % chunkCapacity;
+    return chunks[chunk].get() + columnOffsets[componentId] + slot * columnStrides[componentId];
+}
+
+std::size_t Archetype::AddRow(int entityId) {
+    const std::size_t row = size;
+
+    // Chunks are kept after they empty out, so only allocate when all of them are full
+    if (row == chunks.size() * chunkCapacity) {
+        chunks.push_back(std::make_unique<unsigned char[]>(chunkBytes));
+    }
+
+    reinterpret_cast<int*>(chunks[row / chunkCapacity].get())[row % chunkCapacity] = entityId;
+    size++;
+
+    return row;
+}
+
+void Archetype::MoveRow(std::size_t row, Archetype* destination, std::size_t destinationRow) {
+    for (std::size_t i = 0; i < componentIds.size(); i++) {
+        void* source = GetComponent(row, componentIds[i]);
+
+        if (destination && destination->HasComponent(componentIds[i])) {
+            componentInfos[i].moveConstruct(destination->GetComponent(destinationRow, componentIds[i]), source);
+        }
+
+        componentInfos[i].destroy(source);
+    }
+}
+
+int Archetype::RemoveRow(std::size_t row, bool destroyComponents) {
+    const std::size_t last = size - 1;
+    int movedEntityId = -1;
+
+    if (destroyComponents) {
+        for (std::size_t i = 0; i < componentIds.size(); i++) {
+            componentInfos[i].destroy(GetComponent(row, componentIds[i]));
+        }
+    }
+
+    // Move the last row into the hole, so the rows stay packed
+    if (row != last) {
+        for (std::size_t i = 0; i < componentIds.size(); i++) {
+            void* lastComponent = GetComponent(last, componentIds[i]);
+            componentInfos[i].moveConstruct(GetComponent(row, componentIds[i]), lastComponent);
+            componentInfos[i].destroy(lastComponent);
+        }
+
+        movedEntityId = GetEntityId(last);
+        reinterpret_cast<int*>(chunks[row / chunkCapacity].get())[row % chunkCapacity] = movedEntityId;
+    }
+
+    size--;
+
+    return movedEntityId;
+}
+
+EntityLocation& ArchetypeStorage::GetLocation(int entityId) {
+    if (static_cast<std::size_t>(entityId) >= entityLocations.size()) {
+        entityLocations.resize(entityId + 1);
+    }
+
+    return entityLocations[entityId];
+}
+
+Archetype* ArchetypeStorage::GetOrCreateArchetype(const Signature& signature) {
+    auto archetype = archetypesPerSignature.find(signature);
+
+    if (archetype != archetypesPerSignature.end()) {
+        return archetype->second.get();
+    }
+
+    auto newArchetype = std::make_unique<Archetype>(signature, componentInfos);
+    archetypes.push_back(newArchetype.get());
+    archetypesPerSignature.emplace(signature, std::move(newArchetype));
+
+    return archetypes.back();
+}
+
+Archetype* ArchetypeStorage::GetArchetypeWith(Archetype* archetype, int componentId) {
+    if (archetype && archetype->addEdges[componentId]) {
+        return archetype->addEdges[componentId];
+    }
+
+    Signature signature = archetype ? archetype->GetSignature() : Signature();
+    signature.set(componentId);
+    Archetype* result = GetOrCreateArchetype(signature);
+
+    if (archetype) {
+        archetype->addEdges[componentId] = result;
+    }
+
+    return result;
+}
+
+Archetype* ArchetypeStorage::GetArchetypeWithout(Archetype* archetype, int componentId) {
+    if (archetype->removeEdges[componentId]) {
+        return archetype->removeEdges[componentId];
+    }
+
+    // Entities without any component do not live in an archetype
+    Signature signature = archetype->GetSignature();
+    signature.reset(componentId);
+    if (signature.none()) {
+        return nullptr;
+    }
+
+    archetype->removeEdges[componentId] = GetOrCreateArchetype(signature);
+
+    return archetype->removeEdges[componentId];
+}
+
+std::size_t ArchetypeStorage::MoveEntity(int entityId, Archetype* destination) {
+    EntityLocation& location = GetLocation(entityId);
+    Archetype* source = location.archetype;
+    const std::size_t row = destination ? destination->AddRow(entityId) : 0;
+
+    if (source) {
+        source->MoveRow(location.row, destination, row);
+
+        const int movedEntityId = source->RemoveRow(location.row, false);
+        if (movedEntityId != -1) {
+            entityLocations[movedEntityId].row = location.row;
+        }
+    }
+
+    location.archetype = destination;
+    location.row = row;
+
+    return row;
+}
+
+void ArchetypeStorage::Remove(int entityId, int componentId) {
+    const EntityLocation& location = GetLocation(entityId);
+
+    if (location.archetype && location.archetype->HasComponent(componentId)) {
+        MoveEntity(entityId, GetArchetypeWithout(location.archetype, componentId));
+    }
+}
+
+void ArchetypeStorage::RemoveEntity(int entityId) {
+    EntityLocation& location = GetLocation(entityId);
+
+    if (location.archetype) {
+        const int movedEntityId = location.archetype->RemoveRow(location.row, true);
+        if (movedEntityId != -1) {
+            entityLocations[movedEntityId].row = location.row;
+        }
+    }
+
+    location = EntityLocation();
+}
+
+void* ArchetypeStorage::Get(int entityId, int componentId) const {
+    assert(static_cast<std::size_t>(entityId) < entityLocations.size() && entityLocations[entityId].archetype &&
+        "Entity has no components");
+
+    const EntityLocation& location = entityLocations[entityId];
+    return location.archetype->GetComponent(location.row, componentId);
+}
+
+Registry::Registry(StorageMode storageMode) : storageMode(storageMode) {
+    // The main thread always has a command buffer
+    SetNumThreads(1);
+
+    if (storageMode == STORAGE_ARCHETYPES) {
+        archetypeStorage = std::make_unique<ArchetypeStorage>();
+    }
+
     Logger::Log("Registry Constructor Called!");
 }
 
@@ -34,12 +317,25 @@ Entity Registry::CreateEntity() {
     std::size_t entityId;
 
     if (freeIds.empty()) {
-        // If there are no free ids waiting to be reused
+        // If there are no free ids waiting to be reused. An id past MAX_ENTITIES would spill into the
+        // generation bits of the handle, so the creation is refused with a handle that is never alive
+        if (numEntities >= MAX_ENTITIES) {
+            Logger::Err("Exceeded the maximum number of entities = " + std::to_string(MAX_ENTITIES));
+            assert(false && "Exceeded the maximum number of entities");
+            return Entity(0, 0, nullptr);
+        }
+
         entityId = numEntities++;
 
         // Resize if needs it
         if (entityId >= entityComponentSignatures.size()) { 
             entityComponentSignatures.resize(entityId + 1);
+            entityGenerations.resize(entityId + 1, 0);
+            entityTags.resize(entityId + 1, 0);
+            entityGroupMasks.resize(entityId + 1);
+            entityIsPending.resize(entityId + 1, 0);
+            entityRemovedComponents.resize(entityId + 1);
+            entitySetComponents.resize(entityId + 1);
         }
     } else {
         // Reuse an id from the list of removed entities
@@ -47,39 +343,157 @@ Entity Registry::CreateEntity() {
         freeIds.pop_front();
     }
 
-    Entity entity(entityId);
-    entity.registry = this;    
+    Entity entity(entityId, entityGenerations[entityId], this);
     entitiesToBeAdded.insert(entity);
+    entityIsPending[entityId] = 1;
 
     Logger::Log("Entity created with id = " + std::to_string(entityId));
 
     return entity;
 }
 
+bool Entity::IsAlive() const {
+    return registry && registry->IsAlive(*this);
+}
+
 void Entity::Kill() {
-    registry->KillEntity(*this);
+    assert(registry);
+    registry->GetCommandBuffer().Kill(*this);
 }
 
-void Entity::Tag(const std::string& tag) {
+void Entity::Tag(NameId tag) {
+    assert(registry);
     registry->TagEntity(*this, tag);
 }
 
-bool Entity::HasTag(const std::string& tag) const {
+bool Entity::HasTag(NameId tag) const {
+    assert(registry);
     return registry->EntityHasTag(*this, tag);
 }
 
-void Entity::Group(const std::string& group) {
+void Entity::Group(NameId group) {
+    assert(registry);
     registry->GroupEntity(*this, group);
 }
 
-bool Entity::BelongsToGroup(const std::string& group) const {
+bool Entity::BelongsToGroup(NameId group) const {
+    assert(registry);
     return registry->EntityBelongsToGroup(*this, group);
 }
 
 void Registry::KillEntity(Entity entity) {
+    // A stale handle refers to an entity that is already gone, its id may belong to a new one
+    if (!IsAlive(entity)) {
+        return;
+    }
+
     entitiesToBeKilled.insert(entity);
 }
 
+CommandBuffer& Registry::GetCommandBuffer() {
+    // Every thread owns its slot, so recording never takes a lock
+    const std::size_t threadIndex = JobSystem::GetThreadIndex();
+    assert(threadIndex < commandBuffers.size() && "Registry::SetNumThreads was not called for this job system");
+
+    return *commandBuffers[threadIndex];
+}
+
+void Registry::SetNumThreads(int numThreads) {
+    for (int i = commandBuffers.size(); i < numThreads; i++) {
+        commandBuffers.push_back(std::make_unique<CommandBuffer>());
+    }
+}
+
+CommandBuffer::~CommandBuffer() {
+    Clear();
+}
+
+void* CommandBuffer::Allocate(std::size_t size, std::size_t alignment) {
+    arenaOffset = (arenaOffset + alignment - 1) & ~(alignment - 1);
+
+    if (arenaBlock == arenaBlocks.size() || arenaOffset + size > ARENA_BLOCK_SIZE) {
+        if (arenaBlock < arenaBlocks.size()) {
+            arenaBlock++;
+        }
+        if (arenaBlock == arenaBlocks.size()) {
+            arenaBlocks.push_back(std::make_unique<unsigned char[]>(ARENA_BLOCK_SIZE));
+        }
+        arenaOffset = 0;
+    }
+
+    void* memory = arenaBlocks[arenaBlock].get() + arenaOffset;
+    arenaOffset += size;
+
+    return memory;
+}
+
+void CommandBuffer::Clear() {
+    for (auto& command : commands) {
+        if (command.type == COMMAND_ADD_COMPONENT && command.component) {
+            command.destroy(command.component);
+        }
+    }
+
+    commands.clear();
+    createdEntities.clear();
+    numCreatedEntities = 0;
+    arenaBlock = 0;
+    arenaOffset = 0;
+}
+
+Entity CommandBuffer::Resolve(Entity entity) const {
+    return entity.registry ? entity : createdEntities[entity.GetId()];
+}
+
+Entity CommandBuffer::CreateEntity() {
+    commands.push_back(Command { COMMAND_CREATE_ENTITY, Entity(0, 0, nullptr), NameId(), nullptr, nullptr, nullptr });
+
+    return Entity(numCreatedEntities++, 0, nullptr);
+}
+
+void CommandBuffer::Tag(Entity entity, NameId tag) {
+    commands.push_back(Command { COMMAND_TAG, entity, tag, nullptr, nullptr, nullptr });
+}
+
+void CommandBuffer::Group(Entity entity, NameId group) {
+    commands.push_back(Command { COMMAND_GROUP, entity, group, nullptr, nullptr, nullptr });
+}
+
+void CommandBuffer::Kill(Entity entity) {
+    commands.push_back(Command { COMMAND_KILL, entity, NameId(), nullptr, nullptr, nullptr });
+}
+
+void CommandBuffer::Playback(Registry& registry) {
+    createdEntities.reserve(numCreatedEntities);
+
+    for (auto& command : commands) {
+        switch (command.type) {
+            case COMMAND_CREATE_ENTITY:
+                createdEntities.push_back(registry.CreateEntity());
+                break;
+            case COMMAND_ADD_COMPONENT:
+                command.apply(registry, Resolve(command.entity), command.component);
+                command.destroy(command.component);
+                command.component = nullptr;
+                break;
+            case COMMAND_REMOVE_COMPONENT:
+                command.apply(registry, Resolve(command.entity), nullptr);
+                break;
+            case COMMAND_TAG:
+                registry.TagEntity(Resolve(command.entity), command.name);
+                break;
+            case COMMAND_GROUP:
+                registry.GroupEntity(Resolve(command.entity), command.name);
+                break;
+            case COMMAND_KILL:
+                registry.KillEntity(Resolve(command.entity));
+                break;
+        }
+    }
+
+    Clear();
+}
+
 void Registry::AddEntityToSystems(Entity entity) {
     const auto entityId = entity.GetId();
     const auto& entityComponentSignature = entityComponentSignatures[entityId];
@@ -96,30 +510,97 @@ void Registry::AddEntityToSystems(Entity entity) {
 }
 
 void Registry::RemoveEntityFromSystems(Entity entity) {
-    for (auto system : systems) {
-        system.second->RemoveEntity(entity);
+    const auto& entityComponentSignature = entityComponentSignatures[entity.GetId()];
+
+    // Only the systems interested in this signature can have the entity as a member
+    for (auto& system : systems) {
+        const auto& systemComponentSignature = system.second->GetComponentSignature();
+
+        if ((entityComponentSignature & systemComponentSignature) == systemComponentSignature) {
+            system.second->RemoveEntity(entity);
+        }
     }
 }
 
+void Registry::RefreshEntity(Entity entity) {
+    const auto entityId = entity.GetId();
+    auto& removedComponents = entityRemovedComponents[entityId];
+
+    for (std::size_t componentId = 0; removedComponents.any() && componentId < MAX_COMPONENTS; componentId++) {
+        if (!removedComponents.test(componentId)) {
+            continue;
+        }
+
+        if (storageMode == STORAGE_ARCHETYPES) {
+            archetypeStorage->Remove(entityId, componentId);
+        } else {
+            componentPools[componentId]->RemoveEntityFromPool(entityId);
+        }
+
+        entityComponentSignatures[entityId].reset(componentId);
+        removedComponents.reset(componentId);
+    }
+
+    // The signature is checked again, a component removed and added back keeps the entity in its systems
+    const auto& entityComponentSignature = entityComponentSignatures[entityId];
+    auto& setComponents = entitySetComponents[entityId];
+
+    for (auto& system : systems) {
+        const auto& systemComponentSignature = system.second->GetComponentSignature();
+
+        if ((entityComponentSignature & systemComponentSignature) != systemComponentSignature) {
+            system.second->RemoveEntity(entity);
+        } else if (!system.second->HasEntity(entity)) {
+            system.second->AddEntity(entity);
+        } else if ((setComponents & systemComponentSignature).any()) {
+            system.second->OnEntityChanged(entity);
+        }
+    }
+
+    setComponents.reset();
+}
+
 void Registry::Update() {
+    // Apply the structural changes the systems recorded during the frame
+    for (auto& commandBuffer : commandBuffers) {
+        commandBuffer->Playback(*this);
+    }
+
     // Process the entities that are waiting to be created to the active Systems
     for (auto entity : entitiesToBeAdded) {
         AddEntityToSystems(entity);
+        entityIsPending[entity.GetId()] = 0;
     }
     entitiesToBeAdded.clear();
 
+    // Process the entities whose components changed after they were added to the systems
+    for (auto entity : entitiesToBeRefreshed) {
+        if (IsAlive(entity)) {
+            RefreshEntity(entity);
+        }
+    }
+    entitiesToBeRefreshed.clear();
+
     // Process the entities that are waiting to be killed from the active Systems
     for (auto entity : entitiesToBeKilled) {
         RemoveEntityFromSystems(entity);
         entityComponentSignatures[entity.GetId()].reset();
+        entityRemovedComponents[entity.GetId()].reset();
+        entitySetComponents[entity.GetId()].reset();
 
         // remove the entity from the component pools
-        for (auto pool : componentPools) {
+        for (auto& pool : componentPools) {
             if (pool) {
                 pool->RemoveEntityFromPool(entity.GetId());
             }
         }
 
+        if (archetypeStorage) {
+            archetypeStorage->RemoveEntity(entity.GetId());
+        }
+
+        // Old handles to this id stop being alive before the id is reused
+        entityGenerations[entity.GetId()] = (entity.GetGeneration() + 1) & ENTITY_GENERATION_MASK;
         freeIds.push_back(entity.GetId());
 
         //remove any traces of entity from the tag/group
@@ -130,62 +611,97 @@ void Registry::Update() {
     entitiesToBeKilled.clear();
 }
 
-void Registry::TagEntity(Entity entity, const std::string& tag) {
-    entityPerTag.emplace(tag, entity);
-    tagPerEntity.emplace(entity.GetId(), tag);
+void Registry::TagEntity(Entity entity, NameId tag) {
+    // An entity has a single tag and a tag names a single entity
+    RemoveEntityTag(entity);
+
+    auto taggedEntity = entityPerTag.find(tag.value);
+    if (taggedEntity != entityPerTag.end()) {
+        RemoveEntityTag(taggedEntity->second);
+    }
+
+    entityPerTag.emplace(tag.value, entity);
+    entityTags[entity.GetId()] = tag.value;
 }
 
-bool Registry::EntityHasTag(Entity entity, const std::string& tag) const {
-	if (tagPerEntity.find(entity.GetId()) == tagPerEntity.end()) {
-		return false;
-	}
-	return entityPerTag.find(tag)->second == entity;
+bool Registry::EntityHasTag(Entity entity, NameId tag) const {
+    return entityTags[entity.GetId()] == tag.value && IsAlive(entity);
 }
 
-Entity Registry::GetEntityByTag(const std::string& tag) const {
-    return entityPerTag.at(tag);
+Entity Registry::GetEntityByTag(NameId tag) const {
+    return entityPerTag.at(tag.value);
 }
 
 void Registry::RemoveEntityTag(Entity entity) {
-	auto taggedEntity = tagPerEntity.find(entity.GetId());
-    if (taggedEntity != tagPerEntity.end()) {
-        auto tag = taggedEntity->second;
+    auto& tag = entityTags[entity.GetId()];
+    if (tag != 0) {
         entityPerTag.erase(tag);
-        tagPerEntity.erase(taggedEntity);
+        tag = 0;
     }
 }
 
-void Registry::GroupEntity(Entity entity, const std::string& group) {
-    entitiesPerGroup.emplace(group, std::set<Entity>());
-    entitiesPerGroup[group].emplace(entity);
-    groupPerEntity.emplace(entity.GetId(), group);
+void Registry::GroupEntity(Entity entity, NameId group) {
+    auto groupIndex = groupIndexPerName.find(group.value);
+    if (groupIndex == groupIndexPerName.end()) {
+        if (groups.size() == MAX_GROUPS) {
+            Logger::Err("Exceeded the maximum number of groups = " + std::to_string(MAX_GROUPS));
+            return;
+        }
+        groupIndex = groupIndexPerName.emplace(group.value, groups.size()).first;
+        groups.emplace_back();
+    }
+
+    const auto entityId = entity.GetId();
+    auto& groupMask = entityGroupMasks[entityId];
+    if (groupMask.test(groupIndex->second)) {
+        return;
+    }
+    groupMask.set(groupIndex->second);
+
+    auto& members = groups[groupIndex->second];
+    if (static_cast<std::size_t>(entityId) >= members.entityIdToIndex.size()) {
+        members.entityIdToIndex.resize(entityId + 1, -1);
+    }
+    members.entityIdToIndex[entityId] = members.entityIds.size();
+    members.entityIds.push_back(entityId);
 }
 
-bool Registry::EntityBelongsToGroup(Entity entity, const std::string& group) const {
-    if (entitiesPerGroup.find(group) == entitiesPerGroup.end()) {
+bool Registry::EntityBelongsToGroup(Entity entity, NameId group) const {
+    auto groupIndex = groupIndexPerName.find(group.value);
+    if (groupIndex == groupIndexPerName.end()) {
         return false;
     }
-    
-	auto groupEntities = entitiesPerGroup.at(group);
-    return groupEntities.find(entity.GetId()) != groupEntities.end();
+
+    return entityGroupMasks[entity.GetId()].test(groupIndex->second) && IsAlive(entity);
 }
 
-std::vector<Entity> Registry::GetEntitiesByGroup(const std::string& group) const {
-    auto& setOfEntities = entitiesPerGroup.at(group);
-    return std::vector<Entity>(setOfEntities.begin(), setOfEntities.end());
+EntityRange Registry::GetEntitiesByGroup(NameId group) {
+    auto groupIndex = groupIndexPerName.find(group.value);
+    if (groupIndex == groupIndexPerName.end()) {
+        return EntityRange(nullptr, nullptr, this);
+    }
+
+    const auto& entityIds = groups[groupIndex->second].entityIds;
+    return EntityRange(entityIds.data(), entityIds.data() + entityIds.size(), this);
 }
 
 void Registry::RemoveEntityGroup(Entity entity) {
-    // if in group, remove entity from group management
-    auto groupedEntity = groupPerEntity.find(entity.GetId());
-    if (groupedEntity != groupPerEntity.end()) {
-        auto group = entitiesPerGroup.find(groupedEntity->second);
-        if (group != entitiesPerGroup.end()) {
-            auto entityInGroup = group->second.find(entity);
-            if (entityInGroup != group->second.end()) {
-                group->second.erase(entityInGroup);
-            }
+    const auto entityId = entity.GetId();
+    auto& groupMask = entityGroupMasks[entityId];
+
+    for (std::size_t groupIndex = 0; groupMask.any(); groupIndex++) {
+        if (!groupMask.test(groupIndex)) {
+            continue;
         }
-        groupPerEntity.erase(groupedEntity);
+        groupMask.reset(groupIndex);
+
+        // Swap the last member into the removed slot to keep the list packed
+        auto& members = groups[groupIndex];
+        const int indexOfRemoved = members.entityIdToIndex[entityId];
+        const int lastEntityId = members.entityIds.back();
+        members.entityIds[indexOfRemoved] = lastEntityId;
+        members.entityIdToIndex[lastEntityId] = indexOfRemoved;
+        members.entityIds.pop_back();
+        members.entityIdToIndex[entityId] = -1;
     }
-}
\ No newline at end of file
+}
@@ -1,5 +1,7 @@
 #ifndef ECS_H
 #define ECS_H
+#include <array>
+#include <cassert>
 #include <bitset>
 #include <vector>
 #include <algorithm>
@@ -7,7 +9,11 @@
 #include <typeindex>
 #include <set>
 #include <memory>
+#include <new>
+#include <tuple>
 #include <deque>
+#include <cstddef>
+#include <cstdint>
 #include "../Logger/Logger.h"
 
 #include <iostream>
@@ -17,6 +23,33 @@ const unsigned int MAX_COMPONENTS = 32;
 // Signature represents the set of components an entity has using bitset
 typedef std::bitset<MAX_COMPONENTS> Signature;
 
+const unsigned int MAX_GROUPS = 32;
+
+// GroupMask represents the set of groups an entity belongs to
+typedef std::bitset<MAX_GROUPS> GroupMask;
+
+// Interned tag or group name, a FNV-1a hash of the string that is computed at compile time for
+// literals (e.g. static constexpr NameId PLAYER("player")), so checks compare integers instead of strings
+struct NameId {
+    std::uint32_t value;
+
+    constexpr NameId() : value(0) {}
+    constexpr NameId(const char* name) : value(Hash(name)) {}
+    NameId(const std::string& name) : NameId(name.c_str()) {}
+
+    bool operator ==(const NameId& other) const { return value == other.value; }
+    bool operator !=(const NameId& other) const { return value != other.value; }
+
+    // 0 is reserved to mean "no name"
+    static constexpr std::uint32_t Hash(const char* name) {
+        std::uint32_t hash = 2166136261u;
+        for (; *name; name++) {
+            hash = (hash ^ static_cast<unsigned char>(*name)) * 16777619u;
+        }
+        return hash ? hash : 1;
+    }
+};
+
 // Base component class to manage unique IDs for components
 struct IComponent {
 protected:
@@ -33,29 +66,45 @@ public:
     }
 };
 
-// Entity represents a game object with a unique ID
+// An entity handle packs the entity id (index) in the low bits and its generation in the high bits
+const unsigned int ENTITY_INDEX_BITS = 20;
+const std::uint32_t ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+const std::uint32_t ENTITY_GENERATION_MASK = (1u << (32 - ENTITY_INDEX_BITS)) - 1;
+const int MAX_ENTITIES = ENTITY_INDEX_MASK + 1;
+
+// Entity represents a game object with a unique ID.
+// The placeholders returned by CommandBuffer::CreateEntity have no registry, they can only be passed back to
+// their buffer; the methods that need the registry assert on them
 class Entity {
 private:
-    int id;
+    std::uint32_t handle;
 
 public:
-    Entity (int id) : id(id) {}; 
+    Entity (int id, std::uint32_t generation, class Registry* registry)
+        : handle(static_cast<std::uint32_t>(id) | (generation << ENTITY_INDEX_BITS)), registry(registry) {};
     Entity(const Entity& entity) = default;
-    int GetId() const { return id; }
+
+    // The id indexes the registry arrays, it is reused after the entity is killed
+    int GetId() const { return handle & ENTITY_INDEX_MASK; }
+    // The generation changes every time the id is reused, so an old handle never aliases a new entity
+    std::uint32_t GetGeneration() const { return handle >> ENTITY_INDEX_BITS; }
+    std::uint32_t GetHandle() const { return handle; }
+    bool IsAlive() const;
     void Kill();
 
     // Manage entity tags and groups
-    void Tag(const std::string& tag);
-    bool HasTag(const std::string& tag) const;
-    void Group(const std::string& group);
-    bool BelongsToGroup(const std::string& group) const;
+    void Tag(NameId tag);
+    bool HasTag(NameId tag) const;
+    void Group(NameId group);
+    bool BelongsToGroup(NameId group) const;
 
     Entity& operator =(const Entity& other) = default;
-    bool operator ==(const Entity& other) const { return id == other.id; }
-    bool operator !=(const Entity& other) const { return id != other.id; }
-    bool operator >(const Entity& other) const { return id > other.id; }
-    bool operator <(const Entity& other) const { return id < other.id; }
+    bool operator ==(const Entity& other) const { return handle == other.handle; }
+    bool operator !=(const Entity& other) const { return handle != other.handle; }
+    bool operator >(const Entity& other) const { return handle > other.handle; }
+    bool operator <(const Entity& other) const { return handle < other.handle; }
 
+    // RemoveComponent takes effect in the next Registry::Update, see Registry::RemoveComponent
     template <typename TComponent, typename ...TArgs> void AddComponent(TArgs&& ...args);
     template <typename TComponent> void RemoveComponent();
     template <typename TComponent> bool HasComponent() const;
@@ -65,20 +114,87 @@ public:
     class Registry* registry;
 };
 
+// Non-owning range over a packed array of entity ids, handing out Entity handles on access.
+// It stays valid until the underlying array changes, which only happens in Registry::Update.
+class EntityRange {
+private:
+    const int* first;
+    const int* last;
+    class Registry* registry;
+
+public:
+    class Iterator {
+    private:
+        const int* current;
+        class Registry* registry;
+
+    public:
+        Iterator(const int* current, class Registry* registry) : current(current), registry(registry) {}
+
+        Entity operator *() const;
+        Iterator& operator ++() { ++current; return *this; }
+        bool operator ==(const Iterator& other) const { return current == other.current; }
+        bool operator !=(const Iterator& other) const { return current != other.current; }
+    };
+
+    EntityRange(const int* first, const int* last, class Registry* registry) : first(first), last(last), registry(registry) {}
+
+    Iterator begin() const { return Iterator(first, registry); }
+    Iterator end() const { return Iterator(last, registry); }
+    std::size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    Entity operator [](std::size_t index) const;
+};
+
+// How a system accesses a component, used to decide which systems can run in parallel
+enum ComponentAccess {
+    ACCESS_READ,
+    ACCESS_WRITE
+};
+
 // Manages entities and generates a unique signature for each component type
 class System { 
 private:
     Signature componentSignature;
-    std::vector<Entity> entities;
+    Signature readSignature;
+    Signature writeSignature;
+    bool isExclusive = false;
+    std::vector<int> entityIds;
+    class Registry* registry = nullptr;
+
+    // Sparse index from entity id to its position in entityIds, -1 when the entity is not a member
+    std::vector<int> entityIdToIndex;
 
 public:
     System() = default;
-    ~System() = default;
+    virtual ~System() = default;
     void AddEntity(Entity entity);
     void RemoveEntity(Entity entity);
-    std::vector<Entity> GetSystemEntities() const;
+    bool HasEntity(Entity entity) const;
+    EntityRange GetSystemEntities() const;
+    const std::vector<int>& GetSystemEntityIds() const;
     const Signature& GetComponentSignature() const;
-    template<typename TComponent> void RequireComponent();
+    const Signature& GetReadSignature() const;
+    const Signature& GetWriteSignature() const;
+    bool IsExclusive() const;
+
+    // Requires the component and declares how the system accesses it
+    template<typename TComponent> void RequireComponent(ComponentAccess access = ACCESS_WRITE);
+
+    // Declares access to a component the system uses without requiring it
+    template<typename TComponent> void UseComponent(ComponentAccess access);
+
+    // Declares that the system changes state outside its components (creating entities, emitting events, ...),
+    // so it can never run in parallel with other systems
+    void RequireExclusiveAccess();
+
+    // Called when an entity starts or stops matching the system, for systems that keep their own per entity state.
+    // OnEntityRemoved can come from a RemoveComponent, after the component was removed, so it should not read it
+    virtual void OnEntityAdded(Entity entity) {}
+    virtual void OnEntityRemoved(Entity entity) {}
+
+    // Called in Registry::Update when a component the system requires was set again on one of its entities
+    virtual void OnEntityChanged(Entity entity) {}
 };
 
 
@@ -88,125 +204,397 @@ public:
     virtual void RemoveEntityFromPool(int entityId) = 0;
 };
 
-// Pool 
+// Number of entity ids covered by each page of the pool sparse array
+const unsigned int POOL_PAGE_SIZE = 1024;
+
+// Pool is a sparse set: a paged sparse array maps entity ids to indexes in the packed
+// component data, and a dense array keeps the owner entity id of each packed element
 template<typename T>
 class Pool : public IPool {
 private:
     std::vector<T> data;
-    int size;
+    std::vector<int> entityIds;
+    std::vector<std::unique_ptr<std::array<int, POOL_PAGE_SIZE>>> sparsePages;
+
+    // Returns the slot in the sparse array for that entity id, allocating the page when needed
+    int& SparseSlot(int entityId) {
+        const std::size_t page = entityId / POOL_PAGE_SIZE;
 
-    // helper maps to keep track of entity ids per index, so the vector is always packed
-    std::unordered_map<int, int> entityIdToIndex;
-    std::unordered_map<int, int> indexToEntityId;
+        if (page >= sparsePages.size()) {
+            sparsePages.resize(page + 1);
+        }
+
+        if (!sparsePages[page]) {
+            sparsePages[page] = std::make_unique<std::array<int, POOL_PAGE_SIZE>>();
+            sparsePages[page]->fill(-1);
+        }
+
+        return (*sparsePages[page])[entityId % POOL_PAGE_SIZE];
+    }
+
+    // Returns the packed index of the entity component, or -1 if the entity has no component in this pool
+    int IndexOf(int entityId) const {
+        const std::size_t page = entityId / POOL_PAGE_SIZE;
+
+        if (page >= sparsePages.size() || !sparsePages[page]) {
+            return -1;
+        }
+
+        return (*sparsePages[page])[entityId % POOL_PAGE_SIZE];
+    }
 
 public:
     Pool(int capacity = 100) { 
-        size = 0; 
-        data.resize(capacity); 
+        data.reserve(capacity);
+        entityIds.reserve(capacity);
     }
 
     virtual ~Pool() = default;
 
-    bool IsEmpty() const { return size == 0; }
-    int GetSize() const { return size; }
-    void Resize(int n) { data.resize(n); }
+    bool IsEmpty() const { return data.empty(); }
+    int GetSize() const { return static_cast<int>(data.size()); }
+
+    void Resize(int n) { 
+        data.reserve(n);
+        entityIds.reserve(n);
+    }
 
     void Clear() { 
         data.clear(); 
-        size = 0;
+        entityIds.clear();
+        sparsePages.clear();
     }
 
-    void Add(T object) { data.push_back(object); }
+    bool Has(int entityId) const { return IndexOf(entityId) != -1; }
 
     void Set(int entityId, T object) { 
-        // if we found this entityId in my pool...
-        if (entityIdToIndex.find(entityId) != entityIdToIndex.end()) {
-            // just need to replace this values
-            int index = entityIdToIndex[entityId];
-            data[index] = object;
-
-        } else {
-            // else we need to add a new object, keep track of the entity ids and their vector indexes
-            int index = size;
-            entityIdToIndex.emplace(entityId, index);
-            indexToEntityId.emplace(index, entityId);
-            
-            if (static_cast<size_t>(index) >= data.capacity()) {
-                // if necessary, we resize by always doubling the current capacity
-                data.resize(size * 2);
-            }
+        int& index = SparseSlot(entityId);
 
-            data[index] = object;
-            size++;
-        } 
+        // if we found this entityId in my pool, just need to replace the value
+        if (index != -1) {
+            data[index] = std::move(object);
+            return;
+        }
+
+        // else we append the new object to the end of the packed arrays
+        index = static_cast<int>(data.size());
+        data.push_back(std::move(object));
+        entityIds.push_back(entityId);
     }
 
+    // Does nothing if the entity has no component in this pool
     void Remove(int entityId) {
-        // Get the index of the entity we want to remove
-        int indexOfRemoved = entityIdToIndex[entityId];
-    
-        // Get the index of the last element in the array
-        int indexOfLast = size - 1;
-    
-        // Move the last element to the position of the removed entity to keep the array packed
-        data[indexOfRemoved] = data[indexOfLast];
-    
-        // Update mappings to reflect the change
-        int entityIdOfLastElement = indexToEntityId[indexOfLast]; // Get the entity ID of the last element
-        entityIdToIndex[entityIdOfLastElement] = indexOfRemoved;  // The entityId of the last element have the index from the removed entityId
-        indexToEntityId[indexOfRemoved] = entityIdOfLastElement;  // The index of the entity removed will point to the last element
-    
-        // Remove the old references to the deleted entity
-        entityIdToIndex.erase(entityId);
-        indexToEntityId.erase(indexOfLast);
-        
-        // Remove size
-        size --;
+        if (!Has(entityId)) {
+            return;
+        }
+
+        int& indexOfRemoved = SparseSlot(entityId);
+        const int indexOfLast = static_cast<int>(data.size()) - 1;
+        const int entityIdOfLast = entityIds[indexOfLast];
+
+        // Move the last element to the position of the removed entity to keep the arrays packed
+        if (indexOfRemoved != indexOfLast) {
+            data[indexOfRemoved] = std::move(data[indexOfLast]);
+            entityIds[indexOfRemoved] = entityIdOfLast;
+            SparseSlot(entityIdOfLast) = indexOfRemoved;
+        }
+
+        // Remove the old reference to the deleted entity
+        indexOfRemoved = -1;
+        data.pop_back();
+        entityIds.pop_back();
     }
 
     void RemoveEntityFromPool(int entityId)  override {
-        if (entityIdToIndex.find(entityId) != entityIdToIndex.end()) {
-            Remove(entityId);
-        }
+        Remove(entityId);
     }
 
+    // The entity must have the component, check with Has first
     T& Get(int entityId) { 
-        int index = entityIdToIndex[entityId];
-        return static_cast<T&>(data[index]); 
+        const int index = IndexOf(entityId);
+        assert(index != -1 && "Entity has no component in this pool");
+        return data[index]; 
     }
 
+    // Access to the packed arrays, entityIds[i] owns data[i]
+    const std::vector<int>& GetEntityIds() const { return entityIds; }
+    int GetEntityId(unsigned int index) const { return entityIds[index]; }
+
     T& operator [](unsigned int index) { return data[index]; }
 };
 
+// Type-erased operations the archetype storage needs to move components between chunks
+struct ComponentInfo {
+    std::size_t size = 0;
+    std::size_t alignment = 0;
+    void (*moveConstruct)(void* destination, void* source) = nullptr;
+    void (*destroy)(void* object) = nullptr;
+
+    template <typename T>
+    static ComponentInfo Of() {
+        ComponentInfo info;
+        info.size = sizeof(T);
+        info.alignment = alignof(T);
+        info.moveConstruct = [](void* destination, void* source) { new (destination) T(std::move(*static_cast<T*>(source))); };
+        info.destroy = [](void* object) { static_cast<T*>(object)->~T(); };
+        return info;
+    }
+};
+
+// Target size in bytes of each archetype chunk
+const std::size_t ARCHETYPE_CHUNK_SIZE = 16 * 1024;
+
+// Archetype stores all entities that share the same signature in fixed-size chunks.
+// Each chunk has a column of entity ids followed by one packed column per component (SoA).
+// Rows are kept packed across chunks, so only the last chunk can be partially filled.
+class Archetype {
+private:
+    Signature signature;
+    std::vector<int> componentIds;
+    std::vector<ComponentInfo> componentInfos;
+    std::array<std::size_t, MAX_COMPONENTS> columnOffsets;
+    std::array<std::size_t, MAX_COMPONENTS> columnStrides;
+    std::size_t chunkCapacity = 0;
+    std::size_t chunkBytes = 0;
+    std::vector<std::unique_ptr<unsigned char[]>> chunks;
+    std::size_t size = 0;
+
+    std::size_t ComputeChunkLayout(std::size_t capacity);
+
+public:
+    // Cached transitions to the archetypes with one component added or removed
+    std::array<Archetype*, MAX_COMPONENTS> addEdges {};
+    std::array<Archetype*, MAX_COMPONENTS> removeEdges {};
+
+    Archetype(const Signature& signature, const std::vector<ComponentInfo>& allComponentInfos);
+    ~Archetype();
+
+    const Signature& GetSignature() const { return signature; }
+    bool HasComponent(int componentId) const { return signature.test(componentId); }
+    std::size_t GetSize() const { return size; }
+    std::size_t GetChunkCapacity() const { return chunkCapacity; }
+    std::size_t GetChunkCount() const { return (size + chunkCapacity - 1) / chunkCapacity; }
+    std::size_t GetChunkSize(std::size_t chunk) const;
+
+    const int* GetEntityIds(std::size_t chunk) const;
+    int GetEntityId(std::size_t row) const;
+    void* GetComponent(std::size_t row, int componentId) const;
+
+    template <typename T>
+    T* GetColumn(std::size_t chunk) const {
+        return reinterpret_cast<T*>(chunks[chunk].get() + columnOffsets[Component<T>::GetId()]);
+    }
+
+    // Appends a row for the entity, with its component memory left uninitialized
+    std::size_t AddRow(int entityId);
+
+    // Moves the components of the row into another archetype row, destroying the ones the destination does not have
+    void MoveRow(std::size_t row, Archetype* destination, std::size_t destinationRow);
+
+    // Fills the row with the last row to keep the chunks packed. Returns the id of the entity that was
+    // moved into the row, or -1 if the removed row was the last one
+    int RemoveRow(std::size_t row, bool destroyComponents);
+};
+
+// Where the archetype storage keeps the components of an entity
+struct EntityLocation {
+    Archetype* archetype = nullptr;
+    std::size_t row = 0;
+};
+
+// Alternative component storage that groups entities by signature instead of keeping one Pool per type
+class ArchetypeStorage {
+private:
+    std::vector<ComponentInfo> componentInfos;
+    std::unordered_map<Signature, std::unique_ptr<Archetype>> archetypesPerSignature;
+    std::vector<Archetype*> archetypes;
+    std::vector<EntityLocation> entityLocations;
+
+    EntityLocation& GetLocation(int entityId);
+    Archetype* GetOrCreateArchetype(const Signature& signature);
+    Archetype* GetArchetypeWith(Archetype* archetype, int componentId);
+    Archetype* GetArchetypeWithout(Archetype* archetype, int componentId);
+    std::size_t MoveEntity(int entityId, Archetype* destination);
+
+public:
+    ArchetypeStorage() = default;
+    ~ArchetypeStorage() = default;
+
+    template <typename T> void Set(int entityId, T component);
+    void Remove(int entityId, int componentId);
+    void RemoveEntity(int entityId);
+    void* Get(int entityId, int componentId) const;
+
+    const std::vector<Archetype*>& GetArchetypes() const { return archetypes; }
+};
+
+// Selects how the Registry stores components
+enum StorageMode {
+    STORAGE_POOLS,
+    STORAGE_ARCHETYPES
+};
+
+template <typename ...TComponents> class ComponentView;
+
+// Records structural changes (creating entities, adding/removing components, tags, groups and kills)
+// to be applied in one batch by Registry::Update. Every thread records into its own buffer, see
+// Registry::GetCommandBuffer, so systems running on worker threads never mutate the Registry directly.
+// The buffers are played back in thread index order, the main thread first.
+class CommandBuffer {
+private:
+    enum CommandType {
+        COMMAND_CREATE_ENTITY,
+        COMMAND_ADD_COMPONENT,
+        COMMAND_REMOVE_COMPONENT,
+        COMMAND_TAG,
+        COMMAND_GROUP,
+        COMMAND_KILL
+    };
+
+    // Commands are plain records, only the component adds and removes go through a typed function
+    struct Command {
+        CommandType type;
+        Entity entity;
+        NameId name;
+        void* component;
+        void (*apply)(Registry& registry, Entity entity, void* component);
+        void (*destroy)(void* component);
+    };
+
+    std::vector<Command> commands;
+    std::vector<Entity> createdEntities;
+    int numCreatedEntities = 0;
+
+    // The components of the recorded adds are built in blocks that never move, reused after every playback
+    static const std::size_t ARENA_BLOCK_SIZE = 16 * 1024;
+    std::vector<std::unique_ptr<unsigned char[]>> arenaBlocks;
+    std::size_t arenaBlock = 0;
+    std::size_t arenaOffset = 0;
+
+    void* Allocate(std::size_t size, std::size_t alignment);
+
+    // Destroys the components that were recorded and not played back, and empties the buffer
+    void Clear();
+
+    // Placeholder entities returned by CreateEntity have no registry, their id is the creation order
+    Entity Resolve(Entity entity) const;
+
+    template <typename TComponent>
+    static void ApplyAdd(Registry& registry, Entity entity, void* component);
+
+    template <typename TComponent>
+    static void ApplyRemove(Registry& registry, Entity entity, void* component);
+
+    template <typename TComponent>
+    static void Destroy(void* component) { static_cast<TComponent*>(component)->~TComponent(); }
+
+public:
+    CommandBuffer() = default;
+    ~CommandBuffer();
+
+    CommandBuffer(const CommandBuffer&) = delete;
+    CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+    // Returns a placeholder that can only be used with this buffer until it is played back
+    Entity CreateEntity();
+
+    template <typename TComponent, typename ...TArgs> void AddComponent(Entity entity, TArgs&& ...args);
+    template <typename TComponent> void RemoveComponent(Entity entity);
+    void Tag(Entity entity, NameId tag);
+    void Group(Entity entity, NameId group);
+    void Kill(Entity entity);
+
+    bool IsEmpty() const { return commands.empty(); }
+
+    // Applies the recorded commands in order and clears the buffer
+    void Playback(Registry& registry);
+};
+
 // Manages the creation and destruction of entities, add systems and components to entities
 class Registry {
 private:
     int numEntities = 0;
+    StorageMode storageMode;
     std::vector<std::shared_ptr<IPool>> componentPools;
+    std::unique_ptr<ArchetypeStorage> archetypeStorage;
     std::vector<Signature> entityComponentSignatures;
     std::unordered_map<std::type_index, std::shared_ptr<System>> systems;
     std::set<Entity> entitiesToBeAdded;
     std::set<Entity> entitiesToBeKilled;
-    std::unordered_map<std::string, Entity> entityPerTag;
-    std::unordered_map<int, std::string> tagPerEntity;
-    std::unordered_map<std::string, std::set<Entity>> entitiesPerGroup;
-    std::unordered_map<int, std::string> groupPerEntity;
+    std::set<Entity> entitiesToBeRefreshed;
+    // One command buffer per job system thread, indexed by JobSystem::GetThreadIndex
+    std::vector<std::unique_ptr<CommandBuffer>> commandBuffers;
     std::deque<int> freeIds;
 
+    // Tags: a tag names a single entity, entityTags holds the tag of every entity id (0 if untagged)
+    std::unordered_map<std::uint32_t, Entity> entityPerTag;
+    std::vector<std::uint32_t> entityTags;
+
+    // Groups: every group gets a bit in the entity group masks and keeps a packed list of its members
+    struct GroupMembers {
+        std::vector<int> entityIds;
+        // Sparse index from entity id to its position in entityIds, -1 when the entity is not a member
+        std::vector<int> entityIdToIndex;
+    };
+    std::vector<GroupMembers> groups;
+    std::unordered_map<std::uint32_t, int> groupIndexPerName;
+    std::vector<GroupMask> entityGroupMasks;
+
+    // Current generation of every entity id, bumped when the entity is killed
+    std::vector<std::uint32_t> entityGenerations;
+
+    // 1 while the entity waits in entitiesToBeAdded, views skip it so they see the same entities as the systems
+    std::vector<std::uint8_t> entityIsPending;
+
+    // Components removed during the frame, they stay in place until Update like the components of killed entities
+    std::vector<Signature> entityRemovedComponents;
+
+    // Components set again during the frame on entities that are already in the systems
+    std::vector<Signature> entitySetComponents;
+
+    // Applies the pending component removals and matches the system membership with the new signature
+    void RefreshEntity(Entity entity);
+
 public:
-    Registry();
+    Registry(StorageMode storageMode = STORAGE_POOLS);
     ~Registry();
 
+    StorageMode GetStorageMode() const { return storageMode; }
+
     // Entity management
     Entity CreateEntity();
 
     void KillEntity(Entity entity);
 
-    // Component management
+    // O(1) check that the handle still refers to the entity it was created for
+    bool IsAlive(Entity entity) const {
+        const std::size_t entityId = entity.GetId();
+        return entityId < entityGenerations.size() && entityGenerations[entityId] == entity.GetGeneration() && entity.registry == this;
+    }
+
+    // True between CreateEntity and the Update that adds the entity to the systems
+    bool IsPending(int entityId) const { return entityIsPending[entityId] != 0; }
+
+    // Returns the handle of the live entity that currently uses this id
+    Entity GetEntity(int entityId) { return Entity(entityId, entityGenerations[entityId], this); }
+
+    // Returns the command buffer of the calling thread, played back at the start of Update
+    CommandBuffer& GetCommandBuffer();
+
+    // Creates a command buffer for every thread of the job system, it must be called before any job records commands
+    void SetNumThreads(int numThreads);
+
+    // Component management. A removal is deferred like a kill: until the next Update, HasComponent still
+    // returns true and GetComponent still returns the removed component, so the systems iterating the entity
+    // in this frame can read it. Adding the component again before Update cancels the removal
     template <typename TComponent, typename ...TArgs> void AddComponent(Entity entity, TArgs&& ...args);
     template <typename TComponent> void RemoveComponent(Entity entity);
     template <typename TComponent> bool HasComponent(Entity entity) const;
     template <typename TComponent> TComponent& GetComponent(Entity entity) const;
+    template <typename TComponent> Pool<TComponent>* GetComponentPool() const;
+
+    // Component queries
+    template <typename ...TComponents> ComponentView<TComponents...> View();
 
     // System management
     template <typename TSystem, typename ...TArgs> void AddSystem(TArgs&& ...args);
@@ -219,27 +607,184 @@ public:
     void RemoveEntityFromSystems(Entity entity);
 
     // Tag Management
-    void TagEntity(Entity entity, const std::string& tag);
-    bool EntityHasTag(Entity entity, const std::string& tag) const;
-    Entity GetEntityByTag(const std::string& tag) const;
+    void TagEntity(Entity entity, NameId tag);
+    bool EntityHasTag(Entity entity, NameId tag) const;
+    Entity GetEntityByTag(NameId tag) const;
     void RemoveEntityTag(Entity entity);
 
     // Group Management
-    void GroupEntity(Entity entity, const std::string& group);
-    bool EntityBelongsToGroup(Entity entity, const std::string& group) const;
-    std::vector<Entity> GetEntitiesByGroup(const std::string& group) const;
+    void GroupEntity(Entity entity, NameId group);
+    bool EntityBelongsToGroup(Entity entity, NameId group) const;
+    EntityRange GetEntitiesByGroup(NameId group);
     void RemoveEntityGroup(Entity entity);
     
-    // Processes the entities that are waiting to be added/killed
+    // Plays back the command buffers and processes the entities that are waiting to be added/killed
     void Update();
 
 };
 
+inline Entity EntityRange::Iterator::operator *() const {
+    return registry->GetEntity(*current);
+}
+
+inline Entity EntityRange::operator [](std::size_t index) const {
+    return registry->GetEntity(first[index]);
+}
+
+// Iterates all entities that have every one of the TComponents and hands out direct references.
+// With pool storage it walks the smallest component pool and reads the other components straight
+// from their pools; with archetype storage it streams the chunks of every matching archetype.
+// Entities created since the last Registry::Update are skipped, like they are for the systems.
+// Adding or removing any of these components while iterating invalidates the view.
+template <typename ...TComponents>
+class ComponentView {
+private:
+    Registry* registry;
+
+    // Pool storage: candidate entities come from the smallest pool and are filtered by the others
+    std::tuple<Pool<TComponents>*...> pools;
+    const std::vector<int>* entityIds = nullptr;
+
+    // Archetype storage: every entity of a matching archetype is a match
+    std::vector<Archetype*> archetypes;
+
+    int GetEntityId(std::size_t segment, std::size_t index) const { return entityIds ? (*entityIds)[index] : archetypes[segment]->GetEntityId(index); }
+
+    // The pool being walked is not tested again, it has the entity by definition
+    template <typename TComponent>
+    bool PoolHas(int entityId) const {
+        const Pool<TComponent>* pool = std::get<Pool<TComponent>*>(pools);
+        return &pool->GetEntityIds() == entityIds || pool->Has(entityId);
+    }
+
+    bool Contains(int entityId) const {
+        return !registry->IsPending(entityId) && (!entityIds || (PoolHas<TComponents>(entityId) && ...));
+    }
+
+    template <typename TFunc>
+    void EachInChunk(TFunc& func, const int* chunkEntityIds, std::size_t count, TComponents*... columns) const {
+        for (std::size_t i = 0; i < count; i++) {
+            if (!registry->IsPending(chunkEntityIds[i])) {
+                func(registry->GetEntity(chunkEntityIds[i]), columns[i]...);
+            }
+        }
+    }
+
+public:
+    class Iterator {
+    private:
+        const ComponentView* view;
+        std::size_t segment;
+        std::size_t index;
+
+        void SkipMissing() {
+            while (segment < view->GetSegmentCount()) {
+                if (index >= view->GetSegmentSize(segment)) {
+                    segment++;
+                    index = 0;
+                } else if (!view->Contains(view->GetEntityId(segment, index))) {
+                    index++;
+                } else {
+                    return;
+                }
+            }
+        }
+
+    public:
+        Iterator(const ComponentView* view, std::size_t segment, std::size_t index) : view(view), segment(segment), index(index) { SkipMissing(); }
+
+        Entity operator *() const { return view->registry->GetEntity(view->GetEntityId(segment, index)); }
+        Iterator& operator ++() { index++; SkipMissing(); return *this; }
+        bool operator ==(const Iterator& other) const { return segment == other.segment && index == other.index; }
+        bool operator !=(const Iterator& other) const { return !(*this == other); }
+    };
+
+    ComponentView(Registry* registry, Pool<TComponents>*... componentPools) : registry(registry), pools(componentPools...) {
+        // If one of the component types was never added there is no pool, so nothing matches
+        if ((componentPools && ...)) {
+            for (const std::vector<int>* ids : { &componentPools->GetEntityIds()... }) {
+                if (!entityIds || ids->size() < entityIds->size()) {
+                    entityIds = ids;
+                }
+            }
+        }
+    }
+
+    ComponentView(Registry* registry, const std::vector<Archetype*>& allArchetypes) : registry(registry) {
+        Signature required;
+        (required.set(Component<TComponents>::GetId()), ...);
+
+        for (Archetype* archetype : allArchetypes) {
+            if ((archetype->GetSignature() & required) == required && archetype->GetSize() > 0) {
+                archetypes.push_back(archetype);
+            }
+        }
+    }
+
+    Iterator begin() const { return Iterator(this, 0, 0); }
+    Iterator end() const { return Iterator(this, GetSegmentCount(), 0); }
+
+    // The view is made of segments of candidate entities: the smallest pool, or one segment per archetype
+    std::size_t GetSegmentCount() const { return entityIds ? 1 : archetypes.size(); }
+    std::size_t GetSegmentSize(std::size_t segment) const { return entityIds ? entityIds->size() : archetypes[segment]->GetSize(); }
+
+    template <typename TComponent>
+    TComponent& Get(Entity entity) const;
+
+    // Calls func(entity, components...) for every matching entity
+    template <typename TFunc>
+    void Each(TFunc func) const {
+        for (std::size_t segment = 0; segment < GetSegmentCount(); segment++) {
+            EachInSegment(segment, 0, GetSegmentSize(segment), func);
+        }
+    }
+
+    // Calls func(entity, components...) for the matching entities in [begin, end) of a segment
+    template <typename TFunc>
+    void EachInSegment(std::size_t segment, std::size_t begin, std::size_t end, TFunc& func) const {
+        if (entityIds) {
+            for (std::size_t i = begin; i < end; i++) {
+                const int entityId = (*entityIds)[i];
+
+                if (Contains(entityId)) {
+                    func(registry->GetEntity(entityId), std::get<Pool<TComponents>*>(pools)->Get(entityId)...);
+                }
+            }
+            return;
+        }
+
+        // Archetype rows are streamed one chunk at a time
+        const Archetype* archetype = archetypes[segment];
+        const std::size_t chunkCapacity = archetype->GetChunkCapacity();
+
+        for (std::size_t row = begin; row < end;) {
+            const std::size_t chunk = row / chunkCapacity;
+            const std::size_t slot = row % chunkCapacity;
+            const std::size_t count = std::min(end - row, chunkCapacity - slot);
+
+            EachInChunk(func, archetype->GetEntityIds(chunk) + slot, count, (archetype->template GetColumn<TComponents>(chunk) + slot)...);
+            row += count;
+        }
+    }
+};
+
 // Template function to require a component in a system by setting the appropriate bit in the signature
 template<typename TComponent> 
-void System::RequireComponent() {
+void System::RequireComponent(ComponentAccess access) {
     const auto componentId = Component<TComponent>::GetId(); // Generates a unique ID for each component type
     componentSignature.set(componentId); // Marks the component as required by setting the corresponding bit to true
+    UseComponent<TComponent>(access);
+}
+
+template<typename TComponent> 
+void System::UseComponent(ComponentAccess access) {
+    const auto componentId = Component<TComponent>::GetId();
+
+    if (access == ACCESS_WRITE) {
+        writeSignature.set(componentId);
+    } else {
+        readSignature.set(componentId);
+    }
 }
 
 // Template function to add a new component to a ...
@@ -248,29 +793,38 @@ void Registry::AddComponent(Entity entity, TArgs&& ...args) {
     std::size_t componentId = Component<TComponent>::GetId();
     const auto entityId = entity.GetId();
 
-    // If the component id is bigger then component pool size we will increase the Pool's size
-    if (componentId >= componentPools.size()) {
-        componentPools.resize(componentId + 1, nullptr);
-    }
-
-    // If we don't have the Pool, it will create it
-    if (!componentPools[componentId]) {
-        std::shared_ptr<Pool<TComponent>> newComponentPool = std::make_shared<Pool<TComponent>>();
-        componentPools[componentId] = newComponentPool;
-    }
-
-    // Get the pool of component values for that component type
-    std::shared_ptr<Pool<TComponent>> componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-
     // Create a new Component object of type T and forward the various parameters to the constructor
     TComponent newComponent(std::forward<TArgs>(args)...);
 
-    // Add the new Component to the Component pool list, using the entity id as index
-    componentPool->Set(entityId, newComponent);
+    if (storageMode == STORAGE_ARCHETYPES) {
+        // Moves the entity to the archetype of its new signature
+        archetypeStorage->Set<TComponent>(entityId, std::move(newComponent));
+    } else {
+        // If the component id is bigger then component pool size we will increase the Pool's size
+        if (componentId >= componentPools.size()) {
+            componentPools.resize(componentId + 1, nullptr);
+        }
+
+        // If we don't have the Pool, it will create it
+        if (!componentPools[componentId]) {
+            std::shared_ptr<Pool<TComponent>> newComponentPool = std::make_shared<Pool<TComponent>>();
+            componentPools[componentId] = newComponentPool;
+        }
+
+        // Add the new Component to the Component pool list, using the entity id as index
+        GetComponentPool<TComponent>()->Set(entityId, std::move(newComponent));
+    }
 
     // Finally, change the component signature of the entity and set the component id on the bitset to 1
     entityComponentSignatures[entityId].set(componentId);
 
+    // A removal of the same component earlier in the frame is cancelled, systems that need it now pick the entity up in Update
+    entityRemovedComponents[entityId].reset(componentId);
+    if (!entityIsPending[entityId]) {
+        entitySetComponents[entityId].set(componentId);
+        entitiesToBeRefreshed.insert(entity);
+    }
+
     Logger::Log("Component id: " + std::to_string(componentId) + " was added to entity id " + std::to_string(entityId));
     
 }
@@ -280,14 +834,16 @@ void Registry::RemoveComponent(Entity entity) {
     const auto componentId = Component<TComponent>::GetId();
     const auto entityId = entity.GetId();
 
-    // Remove the compnent from the component list for that entity
-    std::shared_ptr<Pool<TComponent>> componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-    componentPool->Remove(entityId);
+    if (!entityComponentSignatures[entityId].test(componentId)) {
+        return;
+    }
 
-    // Set this component signature for that entity to false
-    entityComponentSignatures[entityId].set(componentId, false);
+    // The component and the system membership go away in Update, so the systems that are iterating
+    // the entity this frame can still read it
+    entityRemovedComponents[entityId].set(componentId);
+    entitiesToBeRefreshed.insert(entity);
 
-    Logger::Log("Component id: " + std::to_string(componentId) + " was removed from entity id " + std::to_string(entityId));
+    Logger::Log("Component id: " + std::to_string(componentId) + " will be removed from entity id " + std::to_string(entityId));
 }
 
 template <typename TComponent>
@@ -300,10 +856,90 @@ bool Registry::HasComponent(Entity entity) const {
 
 template <typename TComponent> 
 TComponent& Registry::GetComponent(Entity entity) const {
-    const auto componentId = Component<TComponent>::GetId();
-    const auto entityId = entity.GetId();
-    auto componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-    return componentPool->Get(entityId);
+    if (storageMode == STORAGE_ARCHETYPES) {
+        return *static_cast<TComponent*>(archetypeStorage->Get(entity.GetId(), Component<TComponent>::GetId()));
+    }
+
+    return GetComponentPool<TComponent>()->Get(entity.GetId());
+}
+
+template <typename TComponent>
+Pool<TComponent>* Registry::GetComponentPool() const {
+    const std::size_t componentId = Component<TComponent>::GetId();
+
+    if (componentId >= componentPools.size()) {
+        return nullptr;
+    }
+
+    return static_cast<Pool<TComponent>*>(componentPools[componentId].get());
+}
+
+template <typename ...TComponents>
+ComponentView<TComponents...> Registry::View() {
+    if (storageMode == STORAGE_ARCHETYPES) {
+        return ComponentView<TComponents...>(this, archetypeStorage->GetArchetypes());
+    }
+
+    return ComponentView<TComponents...>(this, GetComponentPool<TComponents>()...);
+}
+
+template <typename ...TComponents>
+template <typename TComponent>
+TComponent& ComponentView<TComponents...>::Get(Entity entity) const {
+    if (entityIds) {
+        return std::get<Pool<TComponent>*>(pools)->Get(entity.GetId());
+    }
+
+    return registry->GetComponent<TComponent>(entity);
+}
+
+template <typename TComponent>
+void CommandBuffer::ApplyAdd(Registry& registry, Entity entity, void* component) {
+    registry.AddComponent<TComponent>(entity, std::move(*static_cast<TComponent*>(component)));
+}
+
+template <typename TComponent>
+void CommandBuffer::ApplyRemove(Registry& registry, Entity entity, void* component) {
+    registry.RemoveComponent<TComponent>(entity);
+}
+
+template <typename TComponent, typename ...TArgs>
+void CommandBuffer::AddComponent(Entity entity, TArgs&& ...args) {
+    static_assert(sizeof(TComponent) <= ARENA_BLOCK_SIZE && alignof(TComponent) <= alignof(std::max_align_t),
+        "Component does not fit in a command buffer block");
+
+    // The component is built now, so the arguments don't need to outlive the call
+    void* component = new (Allocate(sizeof(TComponent), alignof(TComponent))) TComponent(std::forward<TArgs>(args)...);
+    commands.push_back(Command { COMMAND_ADD_COMPONENT, entity, NameId(), component, &ApplyAdd<TComponent>, &Destroy<TComponent> });
+}
+
+template <typename TComponent>
+void CommandBuffer::RemoveComponent(Entity entity) {
+    commands.push_back(Command { COMMAND_REMOVE_COMPONENT, entity, NameId(), nullptr, &ApplyRemove<TComponent>, nullptr });
+}
+
+template <typename T>
+void ArchetypeStorage::Set(int entityId, T component) {
+    const std::size_t componentId = Component<T>::GetId();
+
+    if (componentId >= componentInfos.size()) {
+        componentInfos.resize(componentId + 1);
+    }
+
+    if (!componentInfos[componentId].destroy) {
+        componentInfos[componentId] = ComponentInfo::Of<T>();
+    }
+
+    // If the entity already has the component we just replace the value
+    const EntityLocation& location = GetLocation(entityId);
+    if (location.archetype && location.archetype->HasComponent(componentId)) {
+        *static_cast<T*>(location.archetype->GetComponent(location.row, componentId)) = std::move(component);
+        return;
+    }
+
+    Archetype* destination = GetArchetypeWith(location.archetype, componentId);
+    const std::size_t row = MoveEntity(entityId, destination);
+    new (destination->GetComponent(row, componentId)) T(std::move(component));
 }
 
 template <typename TSystem, typename ...TArgs> 
@@ -331,21 +967,25 @@ TSystem& Registry::GetSystem() const {
 
 template <typename TComponent, typename ...TArgs> 
 void Entity::AddComponent(TArgs&& ...args) {
+    assert(registry);
     registry->AddComponent<TComponent>(*this, std::forward<TArgs>(args)...);
 }
 
 template <typename TComponent> 
 void Entity::RemoveComponent() {
+    assert(registry);
     registry->RemoveComponent<TComponent>(*this);
 }
 
 template <typename TComponent> 
 bool Entity::HasComponent() const {
+    assert(registry);
     return registry->HasComponent<TComponent>(*this);
 }
 
 template <typename TComponent> 
 TComponent& Entity::GetComponent() const {
+    assert(registry);
     return registry->GetComponent<TComponent>(*this);
 }
 
@@ -0,0 +1,68 @@
+#include "SystemScheduler.h"
+
+SystemScheduler::SystemScheduler(JobSystem& jobSystem) : jobSystem(jobSystem) {
+}
+
+void SystemScheduler::AddTask(const System& system, std::function<void()> function) {
+    Task task;
+    task.readSignature = system.GetReadSignature();
+    task.writeSignature = system.GetWriteSignature();
+    task.isExclusive = system.IsExclusive();
+    task.function = std::move(function);
+    task.pendingDependencies = std::make_unique<std::atomic<int>>(0);
+    tasks.push_back(std::move(task));
+}
+
+bool SystemScheduler::Conflicts(const Task& a, const Task& b) {
+    if (a.isExclusive || b.isExclusive) {
+        return true;
+    }
+
+    // Two systems conflict if one writes a component the other reads or writes
+    return (a.writeSignature & (b.readSignature | b.writeSignature)).any() ||
+           (b.writeSignature & a.readSignature).any();
+}
+
+void SystemScheduler::BuildDependencyGraph() {
+    for (std::size_t i = 0; i < tasks.size(); i++) {
+        for (std::size_t j = i + 1; j < tasks.size(); j++) {
+            if (Conflicts(tasks[i], tasks[j])) {
+                tasks[i].dependents.push_back(j);
+                (*tasks[j].pendingDependencies)++;
+            }
+        }
+    }
+}
+
+void SystemScheduler::SubmitTask(int taskIndex) {
+    jobSystem.Submit([this, taskIndex]() {
+        Task& task = tasks[taskIndex];
+        task.function();
+
+        // Release the tasks that were only waiting for this one, before this job counts as done
+        for (int dependent : task.dependents) {
+            if (--(*tasks[dependent].pendingDependencies) == 0) {
+                SubmitTask(dependent);
+            }
+        }
+    }, &frameCounter, "SystemScheduler");
+}
+
+void SystemScheduler::Run() {
+    BuildDependencyGraph();
+
+    // The roots are picked before any of them runs, a finished root already submits the dependents it releases
+    std::vector<int> roots;
+    for (std::size_t i = 0; i < tasks.size(); i++) {
+        if (*tasks[i].pendingDependencies == 0) {
+            roots.push_back(i);
+        }
+    }
+
+    for (int root : roots) {
+        SubmitTask(root);
+    }
+
+    jobSystem.Wait(frameCounter);
+    tasks.clear();
+}
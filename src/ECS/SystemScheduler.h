@@ -0,0 +1,44 @@
+#ifndef SYSTEMSCHEDULER_H
+#define SYSTEMSCHEDULER_H
+
+#include "ECS.h"
+#include "../JobSystem/JobSystem.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Runs the system updates of a frame as jobs of the JobSystem.
+// Tasks are added in the order they would run serially; a task waits for every earlier task
+// it conflicts with, so systems that don't touch the same components run at the same time.
+class SystemScheduler {
+private:
+    struct Task {
+        Signature readSignature;
+        Signature writeSignature;
+        bool isExclusive;
+        std::function<void()> function;
+        std::vector<int> dependents;
+        std::unique_ptr<std::atomic<int>> pendingDependencies;
+    };
+
+    JobSystem& jobSystem;
+    std::vector<Task> tasks;
+    JobCounter frameCounter;
+
+    static bool Conflicts(const Task& a, const Task& b);
+    void BuildDependencyGraph();
+    void SubmitTask(int taskIndex);
+
+public:
+    SystemScheduler(JobSystem& jobSystem);
+    ~SystemScheduler() = default;
+
+    // Adds the update of a system for this frame, using the component access the system declared
+    void AddTask(const System& system, std::function<void()> function);
+
+    // Runs all the tasks added since the last call and waits for them to finish
+    void Run();
+};
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef COLLISIONENTEREVENT_H
+#define COLLISIONENTEREVENT_H
+
+#include "CollisionEvent.h"
+
+// Emitted in the first frame two colliders overlap
+class CollisionEnterEvent : public CollisionEvent {
+public:
+    CollisionEnterEvent (Entity a, Entity b) : CollisionEvent(a, b) {}
+};
+#endif
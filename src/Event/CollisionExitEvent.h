@@ -0,0 +1,11 @@
+#ifndef COLLISIONEXITEVENT_H
+#define COLLISIONEXITEVENT_H
+
+#include "CollisionEvent.h"
+
+// Emitted in the first frame two colliders stop overlapping, the entities may be dead already
+class CollisionExitEvent : public CollisionEvent {
+public:
+    CollisionExitEvent (Entity a, Entity b) : CollisionEvent(a, b) {}
+};
+#endif
@@ -19,8 +19,10 @@
 #include "../Components/ProjectileEmitterComponent.h"
 #include "../Components/HealthComponent.h"
 #include "../Components/TextLabelComponent.h"
+#include "../Components/TilemapComponent.h"
 #include "../Systems/MovementSystem.h"
 #include "../Systems/RenderSystem.h"
+#include "../Systems/RenderTilemapSystem.h"
 #include "../Systems/AnimationSystem.h"
 #include "../Systems/CollisionSystem.h"
 #include "../Systems/RenderColliderSystem.h"
@@ -42,9 +44,17 @@ int Game::mapHeight;
 Game::Game() {
     isRunning = false;
     isDebug = false;
+#ifdef ARCHETYPE_STORAGE
+    // Components grouped by signature in chunks, to compare against the per-type pools
+    registry = std::make_unique<Registry>(STORAGE_ARCHETYPES);
+#else
     registry = std::make_unique<Registry>();
+#endif
     assetStore = std::make_unique<AssetStore>();
     eventBus = std::make_unique<EventBus>();
+    jobSystem = std::make_unique<JobSystem>();
+    scheduler = std::make_unique<SystemScheduler>(*jobSystem);
+    registry->SetNumThreads(jobSystem->GetNumThreads());
     Logger::Log("Game Constructor called!");
 }
 
@@ -168,6 +178,11 @@ void Game::ProcessInput() {
                 // testing key pressed 
                 eventBus->EmitEvent<KeyPressedEvent>(sdlEvent.key.keysym.sym);
 
+                break;
+            case SDL_RENDER_TARGETS_RESET:
+            case SDL_RENDER_DEVICE_RESET:
+                // The baked tilemap chunks lost their pixels
+                registry->GetSystem<RenderTilemapSystem>().InvalidateChunks();
                 break;
         }
     }
@@ -177,6 +192,7 @@ void Game::LoadLevel(int level) {
     // Adding Systems
     registry->AddSystem<MovementSystem>();
     registry->AddSystem<RenderSystem>();
+    registry->AddSystem<RenderTilemapSystem>();
     registry->AddSystem<AnimationSystem>();
     registry->AddSystem<CollisionSystem>();
     registry->AddSystem<RenderColliderSystem>();
@@ -196,6 +212,10 @@ void Game::LoadLevel(int level) {
     assetStore->AddTexture(renderer, "radar-image", "./assets/images/radar.png");
     assetStore->AddTexture(renderer, "tilemap-image", "./assets/tilemaps/jungle.png");
     assetStore->AddTexture(renderer, "bullet-image", "./assets/images/bullet.png");
+
+    // sprites of all the images share a few atlas textures, so the render system can batch them
+    assetStore->BuildAtlas(renderer);
+
     assetStore->AddFont("charriot-font", "./assets/fonts/charriot.ttf", 22);
     assetStore->AddFont("pico8-font-5", "./assets/fonts/arial.ttf", 5 * 2);
     assetStore->AddFont("pico8-font-10", "./assets/fonts/arial.ttf", 10 * 2);
@@ -206,9 +226,17 @@ void Game::LoadLevel(int level) {
     int mapNumCols = 25;
     int mapNumRows = 20;
 
+    // Solid tiles go to the collision bitmap instead of getting a collider each
+    auto& collisionSystem = registry->GetSystem<CollisionSystem>();
+    collisionSystem.GetTileMap().Configure(mapNumCols, mapNumRows, tileSize * tileScale);
+
     std::fstream mapFile;
     mapFile.open("./assets/tilemaps/jungle.map");
 
+    // The tiles are baked into chunk textures by the tilemap render system, they are not entities
+    std::vector<SDL_Point> tiles;
+    tiles.reserve(mapNumCols * mapNumRows);
+
     for (int y = 0; y < mapNumRows; y++) {
         for (int x = 0; x < mapNumCols; x++) {
             char ch;
@@ -218,26 +246,57 @@ void Game::LoadLevel(int level) {
             int srcRectX = std::atoi(&ch) * tileSize;
             mapFile.ignore();
 
-            Entity tile = registry->CreateEntity();
-            tile.Group("tiles");
-            tile.AddComponent<TransformComponent>(glm::vec2(x * (tileScale * tileSize), y * (tileScale * tileSize)), glm::vec2(tileScale, tileScale), 0.0);
-            tile.AddComponent<SpriteComponent>("tilemap-image", tileSize, tileSize, 0, false, srcRectX, srcRectY);
+            tiles.push_back({srcRectX, srcRectY});
         }
     }
     
     mapFile.close();
 
+    // Solid tiles come from the collision layer of the level, a 0 or 1 per tile laid out like the map.
+    // The jungle marks the open water, a level without a collision layer has no solid tiles
+    std::fstream collisionFile;
+    collisionFile.open("./assets/tilemaps/jungle.collision");
+
+    if (collisionFile.is_open()) {
+        for (int y = 0; y < mapNumRows; y++) {
+            for (int x = 0; x < mapNumCols; x++) {
+                char ch;
+                collisionFile.get(ch);
+                collisionSystem.GetTileMap().SetSolid(x, y, ch == '1');
+                collisionFile.ignore();
+            }
+        }
+
+        collisionFile.close();
+    }
+
+    Entity tilemap = registry->CreateEntity();
+    tilemap.AddComponent<TilemapComponent>("tilemap-image", tileSize, tileScale, mapNumCols, mapNumRows, tiles);
+
     // to help us to limit the camera movement
     mapWidth = mapNumCols * tileSize * tileScale;
     mapHeight = mapNumRows * tileSize * tileScale;
 
+    // the collision broad phase grid covers the map
+    collisionSystem.SetWorldBounds(mapWidth, mapHeight);
+
+    // only the pairs the damage system cares about generate collisions, the chopper and the bullets fly over solid tiles
+    collisionSystem.SetLayersCollide(LAYER_PLAYER, LAYER_TILE, false);
+    collisionSystem.SetLayersCollide(LAYER_PLAYER_PROJECTILE, LAYER_TILE, false);
+    collisionSystem.SetLayersCollide(LAYER_ENEMY_PROJECTILE, LAYER_TILE, false);
+    collisionSystem.SetLayersCollide(LAYER_PLAYER, LAYER_PLAYER_PROJECTILE, false);
+    collisionSystem.SetLayersCollide(LAYER_ENEMY, LAYER_ENEMY_PROJECTILE, false);
+    collisionSystem.SetLayersCollide(LAYER_PLAYER_PROJECTILE, LAYER_PLAYER_PROJECTILE, false);
+    collisionSystem.SetLayersCollide(LAYER_PLAYER_PROJECTILE, LAYER_ENEMY_PROJECTILE, false);
+    collisionSystem.SetLayersCollide(LAYER_ENEMY_PROJECTILE, LAYER_ENEMY_PROJECTILE, false);
+
     Entity chopper = registry->CreateEntity();
     chopper.Tag("player");
     chopper.AddComponent<TransformComponent>(glm::vec2(10.0, 10.0), glm::vec2(1.0, 1.0), 0.0);
     chopper.AddComponent<RigidBodyComponent>(glm::vec2(0.0, 0.0));
     chopper.AddComponent<SpriteComponent>("chopper-image", 32, 32, 1);
     chopper.AddComponent<AnimationComponent>(2, 15, true);
-    chopper.AddComponent<BoxColliderComponent>(32, 32);
+    chopper.AddComponent<BoxColliderComponent>(32, 32, glm::vec2(0), LAYER_PLAYER);
     chopper.AddComponent<KeyboardControlledComponent>(glm::vec2(0, -80), glm::vec2(80, 0), glm::vec2(0, 80), glm::vec2(-80, 0));
     chopper.AddComponent<CameraFollowComponent>();
     chopper.AddComponent<ProjectileEmitterComponent>(glm::vec2(150.0, 150.0), 0, 10000, 10, true);
@@ -253,7 +312,7 @@ void Game::LoadLevel(int level) {
     tank.AddComponent<TransformComponent>(glm::vec2(800.0, 10.0), glm::vec2(1.0, 1.0), 0.0);
     tank.AddComponent<RigidBodyComponent>(glm::vec2(0.0, 0.0));
     tank.AddComponent<SpriteComponent>("tank-image", 32, 32, 2);
-    tank.AddComponent<BoxColliderComponent>(32, 32);
+    tank.AddComponent<BoxColliderComponent>(32, 32, glm::vec2(0), LAYER_ENEMY);
     tank.AddComponent<ProjectileEmitterComponent>(glm::vec2(-100,0), 900, 1200, 10, false);
     tank.AddComponent<HealthComponent>(50);
 
@@ -262,7 +321,7 @@ void Game::LoadLevel(int level) {
     truck.AddComponent<TransformComponent>(glm::vec2(250.0, 10.0), glm::vec2(1.0, 1.0), 0.0);
     truck.AddComponent<RigidBodyComponent>(glm::vec2(0.0, 0.0));
     truck.AddComponent<SpriteComponent>("truck-image", 32, 32, 1);
-    truck.AddComponent<BoxColliderComponent>(32, 32);
+    truck.AddComponent<BoxColliderComponent>(32, 32, glm::vec2(0), LAYER_ENEMY);
     truck.AddComponent<ProjectileEmitterComponent>(glm::vec2(0,100), 900, 1200, 10, false);
     truck.AddComponent<HealthComponent>(50);
 
@@ -297,21 +356,29 @@ void Game::Update() {
     eventBus->Reset();
 
     // Perform subscription of the events for all systems
-    registry->GetSystem<DamageSystem>().SubscribeToEvents(eventBus);
     registry->GetSystem<KeyboardControlSystem>().SubscribeToEvents(eventBus);
     registry->GetSystem<ProjectileEmitSystem>().SubscribeToEvents(eventBus);
 
     // Update the registry to process the entities that are waiting to be created/deleted
     registry->Update();
 
-    // Update from systems
-    registry->GetSystem<MovementSystem>().Update(deltaTime);
-    registry->GetSystem<AnimationSystem>().Update();
-    registry->GetSystem<CollisionSystem>().Update(eventBus);
-    registry->GetSystem<DamageSystem>().Update();
-    registry->GetSystem<CameraMovementSystem>().Update(camera);
-    registry->GetSystem<ProjectileEmitSystem>().Update(registry);
-    registry->GetSystem<ProjectileLifecycleSystem>().Update();
+    // Update from systems, the scheduler runs the ones that don't share components in parallel
+    auto& movementSystem = registry->GetSystem<MovementSystem>();
+    auto& animationSystem = registry->GetSystem<AnimationSystem>();
+    auto& collisionSystem = registry->GetSystem<CollisionSystem>();
+    auto& damageSystem = registry->GetSystem<DamageSystem>();
+    auto& cameraMovementSystem = registry->GetSystem<CameraMovementSystem>();
+    auto& projectileEmitSystem = registry->GetSystem<ProjectileEmitSystem>();
+    auto& projectileLifecycleSystem = registry->GetSystem<ProjectileLifecycleSystem>();
+
+    scheduler->AddTask(movementSystem, [&]() { movementSystem.Update(registry, jobSystem, deltaTime); });
+    scheduler->AddTask(animationSystem, [&]() { animationSystem.Update(registry, jobSystem); });
+    scheduler->AddTask(collisionSystem, [&]() { collisionSystem.Update(jobSystem, eventBus); });
+    scheduler->AddTask(damageSystem, [&]() { damageSystem.Update(collisionSystem.GetContacts()); });
+    scheduler->AddTask(cameraMovementSystem, [&]() { cameraMovementSystem.Update(camera); });
+    scheduler->AddTask(projectileEmitSystem, [&]() { projectileEmitSystem.Update(registry); });
+    scheduler->AddTask(projectileLifecycleSystem, [&]() { projectileLifecycleSystem.Update(); });
+    scheduler->Run();
 }
 
 void Game::Render() {
@@ -319,14 +386,15 @@ void Game::Render() {
     SDL_SetRenderDrawColor(renderer, 21, 21, 21, 255); 
     SDL_RenderClear(renderer);
 
-    // Updating all the rendering objects
+    // Updating all the rendering objects, the tilemap goes under the sprites
+    registry->GetSystem<RenderTilemapSystem>().Update(renderer, assetStore, camera);
     registry->GetSystem<RenderSystem>().Update(renderer, assetStore, camera);
     registry->GetSystem<RenderTextSystem>().Update(renderer, assetStore, camera);
     registry->GetSystem<RenderHealthBarSystem>().Update(renderer, assetStore, camera);
     
     if (isDebug) {
         registry->GetSystem<RenderColliderSystem>().Update(renderer, camera);
-        registry->GetSystem<RenderGUISystem>().Update(registry, camera);
+        registry->GetSystem<RenderGUISystem>().Update(registry, assetStore, camera);
     }
 
     // Presents the renderer (swap the buffers to display the current frame)
@@ -2,6 +2,8 @@
 #define GAME_H
 
 #include "../ECS/ECS.h"
+#include "../ECS/SystemScheduler.h"
+#include "../JobSystem/JobSystem.h"
 #include "../AssetStore/AssetStore.h"
 #include "../EventBus/EventBus.h"
 #include <SDL2/SDL.h>
@@ -21,6 +23,8 @@ private:
     std::unique_ptr<Registry> registry;
     std::unique_ptr<AssetStore> assetStore;
     std::unique_ptr<EventBus> eventBus;
+    std::unique_ptr<JobSystem> jobSystem;
+    std::unique_ptr<SystemScheduler> scheduler;
 
 public:
     Game();
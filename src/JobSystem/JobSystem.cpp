@@ -0,0 +1,158 @@
+#include "JobSystem.h"
+#include "../Logger/Logger.h"
+
+// Index of the queue owned by the current thread, workers get theirs when they start
+static thread_local int threadIndex = 0;
+
+JobSystem::JobSystem(int numWorkers) {
+    if (numWorkers < 0) {
+        numWorkers = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    }
+
+    // One queue for the main thread plus one per worker
+    for (int i = 0; i <= numWorkers; i++) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    for (int i = 1; i <= numWorkers; i++) {
+        workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+
+    Logger::Log("JobSystem started with " + std::to_string(numWorkers) + " worker threads");
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        isStopping = true;
+    }
+
+    jobAvailable.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+int JobSystem::GetThreadIndex() {
+    return threadIndex;
+}
+
+void JobSystem::SetTimingCallback(std::function<void(const JobTiming&)> callback) {
+    timingCallback = std::move(callback);
+}
+
+void JobSystem::Submit(Job job, JobCounter* counter, const char* name) {
+    if (counter) {
+        counter->count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Threads that don't belong to this job system share the main thread queue
+    const int queueIndex = threadIndex < GetNumThreads() ? threadIndex : 0;
+    {
+        std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+        queues[queueIndex]->jobs.push_back({std::move(job), counter, name});
+    }
+
+    pendingJobs.fetch_add(1, std::memory_order_release);
+
+    {
+        // Taking the lock makes sure a worker going to sleep sees the new job
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    jobAvailable.notify_one();
+}
+
+bool JobSystem::PopJob(int queueIndex, JobEntry& entry) {
+    WorkQueue& queue = *queues[queueIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.jobs.empty()) {
+        return false;
+    }
+
+    // The owner takes the most recent job, which is the most likely to be in cache
+    entry = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+
+    return true;
+}
+
+bool JobSystem::StealJob(int thiefIndex, JobEntry& entry) {
+    const int numQueues = GetNumThreads();
+
+    for (int i = 1; i < numQueues; i++) {
+        WorkQueue& queue = *queues[(thiefIndex + i) % numQueues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        // Thieves take the oldest job, which is usually the biggest remaining piece of work
+        if (!queue.jobs.empty()) {
+            entry = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool JobSystem::TryExecuteJob() {
+    const int queueIndex = threadIndex < GetNumThreads() ? threadIndex : 0;
+    JobEntry entry;
+
+    if (PopJob(queueIndex, entry) || StealJob(queueIndex, entry)) {
+        Execute(entry);
+        return true;
+    }
+
+    return false;
+}
+
+void JobSystem::Execute(JobEntry& entry) {
+    pendingJobs.fetch_sub(1, std::memory_order_relaxed);
+
+    if (timingCallback) {
+        const auto start = std::chrono::steady_clock::now();
+        entry.job();
+        timingCallback({entry.name, threadIndex, start, std::chrono::steady_clock::now() - start});
+    } else {
+        entry.job();
+    }
+
+    if (entry.counter) {
+        entry.counter->count.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void JobSystem::WorkerLoop(int workerIndex) {
+    threadIndex = workerIndex;
+
+    while (!isStopping) {
+        if (TryExecuteJob()) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        jobAvailable.wait(lock, [this]() { return isStopping || pendingJobs.load(std::memory_order_acquire) > 0; });
+    }
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+    while (!counter.IsDone()) {
+        if (!TryExecuteJob()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::ParallelFor(std::size_t count, std::size_t chunkSize, const std::function<void(std::size_t, std::size_t)>& func, const char* name) {
+    JobCounter counter;
+    chunkSize = std::max<std::size_t>(1, chunkSize);
+
+    for (std::size_t begin = 0; begin < count; begin += chunkSize) {
+        const std::size_t end = std::min(count, begin + chunkSize);
+        Submit([&func, begin, end]() { func(begin, end); }, &counter, name);
+    }
+
+    Wait(counter);
+}
@@ -0,0 +1,128 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Target amount of component data touched by each job of a ParallelForEach
+const std::size_t JOB_CHUNK_BYTES = 16 * 1024;
+
+// Number of entities per job when iterating a system membership
+const std::size_t JOB_CHUNK_ENTITIES = 256;
+
+// Counts the unfinished jobs of a batch, so the caller can wait for all of them
+class JobCounter {
+private:
+    std::atomic<int> count {0};
+    friend class JobSystem;
+
+public:
+    bool IsDone() const { return count.load(std::memory_order_acquire) == 0; }
+};
+
+// Timing of a finished job, reported to the timing callback
+struct JobTiming {
+    const char* name;
+    int workerIndex;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::duration duration;
+};
+
+// Engine job system: every thread has its own job deque, it pushes and pops jobs at the back,
+// and threads that run out of work steal from the front of the others' deques.
+// Index 0 is used by the main thread (and any thread that is not a worker).
+class JobSystem {
+public:
+    typedef std::function<void()> Job;
+
+private:
+    struct JobEntry {
+        Job job;
+        JobCounter* counter;
+        const char* name;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<JobEntry> jobs;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<int> pendingJobs {0};
+    std::atomic<bool> isStopping {false};
+    std::mutex sleepMutex;
+    std::condition_variable jobAvailable;
+    std::function<void(const JobTiming&)> timingCallback;
+
+    bool PopJob(int queueIndex, JobEntry& entry);
+    bool StealJob(int thiefIndex, JobEntry& entry);
+    bool TryExecuteJob();
+    void Execute(JobEntry& entry);
+    void WorkerLoop(int workerIndex);
+
+public:
+    // A negative number of workers uses one worker per core besides the main thread
+    JobSystem(int numWorkers = -1);
+    ~JobSystem();
+
+    // Queues a job on the calling thread's deque, the counter (optional) tracks its completion
+    void Submit(Job job, JobCounter* counter = nullptr, const char* name = "");
+
+    // Waits for all jobs of the counter, running queued jobs meanwhile instead of blocking
+    void Wait(JobCounter& counter);
+
+    // Splits [0, count) in ranges of chunkSize and calls func(begin, end) for each one in parallel
+    void ParallelFor(std::size_t count, std::size_t chunkSize, const std::function<void(std::size_t, std::size_t)>& func, const char* name = "");
+
+    // Calls func(entity) for every entity of a system membership in parallel
+    template <typename TFunc>
+    void ParallelForEach(const EntityRange& entities, TFunc func, const char* name = "");
+
+    // Calls func(entity, components...) for every entity of a view in parallel
+    template <typename ...TComponents, typename TFunc>
+    void ParallelForEach(const ComponentView<TComponents...>& view, TFunc func, const char* name = "");
+
+    // Called after every job with its timing, from the thread that ran it
+    void SetTimingCallback(std::function<void(const JobTiming&)> callback);
+
+    int GetNumThreads() const { return queues.size(); }
+    static int GetThreadIndex();
+};
+
+template <typename TFunc>
+void JobSystem::ParallelForEach(const EntityRange& entities, TFunc func, const char* name) {
+    ParallelFor(entities.size(), JOB_CHUNK_ENTITIES, [&entities, &func](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            func(entities[i]);
+        }
+    }, name);
+}
+
+template <typename ...TComponents, typename TFunc>
+void JobSystem::ParallelForEach(const ComponentView<TComponents...>& view, TFunc func, const char* name) {
+    const std::size_t chunkSize = std::max<std::size_t>(1, JOB_CHUNK_BYTES / (sizeof(TComponents) + ...));
+    JobCounter counter;
+
+    for (std::size_t segment = 0; segment < view.GetSegmentCount(); segment++) {
+        const std::size_t size = view.GetSegmentSize(segment);
+
+        for (std::size_t begin = 0; begin < size; begin += chunkSize) {
+            const std::size_t end = std::min(size, begin + chunkSize);
+            Submit([&view, &func, segment, begin, end]() { view.EachInSegment(segment, begin, end, func); }, &counter, name);
+        }
+    }
+
+    Wait(counter);
+}
+
+#endif
@@ -4,9 +4,13 @@
 #include <chrono>
 #include <ctime>
 #include <cstring>
+#include <mutex>
 
 std::vector<LogEntry> Logger::messages;
 
+// Systems can log from worker threads
+static std::mutex messagesMutex;
+
 std::string CurrentDateTimeToString() {
     // TODO: Try to improve this part of the code to use a more modern formatting approach
     // Get the current time from the system clock
@@ -27,6 +31,9 @@ std::string CurrentDateTimeToString() {
 }
 
 void Logger::AddLogEntry(LogType type, const std::string& prefix, const std::string& color, const std::string& message) {
+    // std::localtime and the messages vector are shared, so the whole entry is built under the lock
+    std::lock_guard<std::mutex> lock(messagesMutex);
+
     LogEntry logEntry;
     logEntry.type = type;
     logEntry.message = prefix + "[" + CurrentDateTimeToString() + "]: " + message;
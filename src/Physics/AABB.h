@@ -0,0 +1,76 @@
+#ifndef AABB_H
+#define AABB_H
+
+#include <algorithm>
+#include <glm/glm.hpp>
+
+// Axis aligned bounding box in world coordinates
+struct AABB {
+    float minX;
+    float minY;
+    float maxX;
+    float maxY;
+
+    AABB(float minX = 0, float minY = 0, float maxX = 0, float maxY = 0) : minX(minX), minY(minY), maxX(maxX), maxY(maxY) {}
+
+    bool Overlaps(const AABB& other) const {
+        return minX < other.maxX && maxX > other.minX && minY < other.maxY && maxY > other.minY;
+    }
+
+    bool Contains(const AABB& other) const {
+        return minX <= other.minX && minY <= other.minY && maxX >= other.maxX && maxY >= other.maxY;
+    }
+
+    float GetPerimeter() const {
+        return 2 * ((maxX - minX) + (maxY - minY));
+    }
+
+    // Slab test of the segment origin + t * delta for t in [0, maxFraction], fraction is where it enters the box
+    bool IntersectsSegment(glm::vec2 origin, glm::vec2 delta, float maxFraction, float& fraction) const {
+        float tMin = 0;
+        float tMax = maxFraction;
+        const float boxMin[2] = {minX, minY};
+        const float boxMax[2] = {maxX, maxY};
+
+        for (int axis = 0; axis < 2; axis++) {
+            if (delta[axis] == 0) {
+                if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis]) {
+                    return false;
+                }
+                continue;
+            }
+
+            float t1 = (boxMin[axis] - origin[axis]) / delta[axis];
+            float t2 = (boxMax[axis] - origin[axis]) / delta[axis];
+            if (t1 > t2) {
+                std::swap(t1, t2);
+            }
+
+            tMin = std::max(tMin, t1);
+            tMax = std::min(tMax, t2);
+            if (tMin > tMax) {
+                return false;
+            }
+        }
+
+        fraction = tMin;
+        return true;
+    }
+
+    static AABB Combine(const AABB& a, const AABB& b) {
+        return AABB(std::min(a.minX, b.minX), std::min(a.minY, b.minY), std::max(a.maxX, b.maxX), std::max(a.maxY, b.maxY));
+    }
+};
+
+// Pair of collider indices, a < b
+struct CollisionPair {
+    int a;
+    int b;
+
+    CollisionPair(int a, int b) : a(std::min(a, b)), b(std::max(a, b)) {}
+
+    bool operator ==(const CollisionPair& other) const { return a == other.a && b == other.b; }
+    bool operator <(const CollisionPair& other) const { return a < other.a || (a == other.a && b < other.b); }
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include "ColliderBounds.h"
+
+// The AVX2 path reads the candidate pairs as an array of ints
+static_assert(sizeof(CollisionPair) == 2 * sizeof(int), "CollisionPair must be two packed ints");
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void ColliderBounds::Clear() {
+    minX.clear();
+    minY.clear();
+    maxX.clear();
+    maxY.clear();
+    layers.clear();
+    masks.clear();
+}
+
+void ColliderBounds::Add(const AABB& box, const CollisionFilter& filter) {
+    minX.push_back(box.minX);
+    minY.push_back(box.minY);
+    maxX.push_back(box.maxX);
+    maxY.push_back(box.maxY);
+    layers.push_back(filter.layer);
+    masks.push_back(filter.mask);
+}
+
+const char* ColliderBounds::GetInstructionSet() {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+void ColliderBounds::FindOverlaps(const std::vector<CollisionPair>& candidates, std::size_t begin, std::size_t end, std::vector<CollisionPair>& overlaps) const {
+    const int last = end;
+    int k = begin;
+
+#if defined(__AVX2__)
+    // Gather the boxes of 8 candidates into registers, the pairs are interleaved a, b, a, b...
+    const __m256i aOffsets = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+    const __m256i bOffsets = _mm256_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15);
+
+    for (; k + 8 <= last; k += 8) {
+        const int* pairIndices = &candidates[k].a;
+        const __m256i a = _mm256_i32gather_epi32(pairIndices, aOffsets, 4);
+        const __m256i b = _mm256_i32gather_epi32(pairIndices, bOffsets, 4);
+
+        const __m256 overlapX = _mm256_and_ps(
+            _mm256_cmp_ps(_mm256_i32gather_ps(minX.data(), a, 4), _mm256_i32gather_ps(maxX.data(), b, 4), _CMP_LT_OQ),
+            _mm256_cmp_ps(_mm256_i32gather_ps(maxX.data(), a, 4), _mm256_i32gather_ps(minX.data(), b, 4), _CMP_GT_OQ));
+        const __m256 overlapY = _mm256_and_ps(
+            _mm256_cmp_ps(_mm256_i32gather_ps(minY.data(), a, 4), _mm256_i32gather_ps(maxY.data(), b, 4), _CMP_LT_OQ),
+            _mm256_cmp_ps(_mm256_i32gather_ps(maxY.data(), a, 4), _mm256_i32gather_ps(minY.data(), b, 4), _CMP_GT_OQ));
+
+        for (int mask = _mm256_movemask_ps(_mm256_and_ps(overlapX, overlapY)); mask; mask &= mask - 1) {
+            overlaps.push_back(candidates[k + FindLowestBit(mask)]);
+        }
+    }
+#elif defined(__SSE2__)
+    // SSE2 has no gather, the 4 candidates are loaded one lane at a time
+    for (; k + 4 <= last; k += 4) {
+        const CollisionPair* pairs = &candidates[k];
+        const int a0 = pairs[0].a, a1 = pairs[1].a, a2 = pairs[2].a, a3 = pairs[3].a;
+        const int b0 = pairs[0].b, b1 = pairs[1].b, b2 = pairs[2].b, b3 = pairs[3].b;
+
+        const __m128 overlapX = _mm_and_ps(
+            _mm_cmplt_ps(_mm_setr_ps(minX[a0], minX[a1], minX[a2], minX[a3]), _mm_setr_ps(maxX[b0], maxX[b1], maxX[b2], maxX[b3])),
+            _mm_cmpgt_ps(_mm_setr_ps(maxX[a0], maxX[a1], maxX[a2], maxX[a3]), _mm_setr_ps(minX[b0], minX[b1], minX[b2], minX[b3])));
+        const __m128 overlapY = _mm_and_ps(
+            _mm_cmplt_ps(_mm_setr_ps(minY[a0], minY[a1], minY[a2], minY[a3]), _mm_setr_ps(maxY[b0], maxY[b1], maxY[b2], maxY[b3])),
+            _mm_cmpgt_ps(_mm_setr_ps(maxY[a0], maxY[a1], maxY[a2], maxY[a3]), _mm_setr_ps(minY[b0], minY[b1], minY[b2], minY[b3])));
+
+        for (int mask = _mm_movemask_ps(_mm_and_ps(overlapX, overlapY)); mask; mask &= mask - 1) {
+            overlaps.push_back(candidates[k + FindLowestBit(mask)]);
+        }
+    }
+#endif
+
+    for (; k < last; k++) {
+        const int a = candidates[k].a;
+        const int b = candidates[k].b;
+
+        if (minX[a] < maxX[b] && maxX[a] > minX[b] && minY[a] < maxY[b] && maxY[a] > minY[b]) {
+            overlaps.push_back(candidates[k]);
+        }
+    }
+}
+
+void ColliderBounds::FindAllOverlaps(std::size_t firstBox, std::size_t lastBox, std::vector<CollisionPair>& overlaps) const {
+    const int numBoxes = GetSize();
+
+    for (int a = firstBox; a < static_cast<int>(lastBox); a++) {
+        int b = a + 1;
+
+#if defined(__AVX2__)
+        // Box a against the next 8 boxes, loaded straight from the arrays
+        const __m256 aMinX = _mm256_set1_ps(minX[a]);
+        const __m256 aMinY = _mm256_set1_ps(minY[a]);
+        const __m256 aMaxX = _mm256_set1_ps(maxX[a]);
+        const __m256 aMaxY = _mm256_set1_ps(maxY[a]);
+        const __m256i aLayer = _mm256_set1_epi32(layers[a]);
+        const __m256i aMask = _mm256_set1_epi32(masks[a]);
+        const __m256i zero = _mm256_setzero_si256();
+
+        for (; b + 8 <= numBoxes; b += 8) {
+            // Lanes where one of the filters rejects the layer of the other
+            const __m256i bLayer = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&layers[b]));
+            const __m256i bMask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&masks[b]));
+            const __m256i rejected = _mm256_or_si256(
+                _mm256_cmpeq_epi32(_mm256_and_si256(aLayer, bMask), zero),
+                _mm256_cmpeq_epi32(_mm256_and_si256(bLayer, aMask), zero));
+
+            const __m256 overlapX = _mm256_and_ps(
+                _mm256_cmp_ps(aMinX, _mm256_loadu_ps(&maxX[b]), _CMP_LT_OQ),
+                _mm256_cmp_ps(aMaxX, _mm256_loadu_ps(&minX[b]), _CMP_GT_OQ));
+            const __m256 overlapY = _mm256_and_ps(
+                _mm256_cmp_ps(aMinY, _mm256_loadu_ps(&maxY[b]), _CMP_LT_OQ),
+                _mm256_cmp_ps(aMaxY, _mm256_loadu_ps(&minY[b]), _CMP_GT_OQ));
+
+            const __m256 overlap = _mm256_andnot_ps(_mm256_castsi256_ps(rejected), _mm256_and_ps(overlapX, overlapY));
+
+            for (int mask = _mm256_movemask_ps(overlap); mask; mask &= mask - 1) {
+                overlaps.emplace_back(a, b + FindLowestBit(mask));
+            }
+        }
+#elif defined(__SSE2__)
+        // Box a against the next 4 boxes, loaded straight from the arrays
+        const __m128 aMinX = _mm_set1_ps(minX[a]);
+        const __m128 aMinY = _mm_set1_ps(minY[a]);
+        const __m128 aMaxX = _mm_set1_ps(maxX[a]);
+        const __m128 aMaxY = _mm_set1_ps(maxY[a]);
+        const __m128i aLayer = _mm_set1_epi32(layers[a]);
+        const __m128i aMask = _mm_set1_epi32(masks[a]);
+        const __m128i zero = _mm_setzero_si128();
+
+        for (; b + 4 <= numBoxes; b += 4) {
+            // Lanes where one of the filters rejects the layer of the other
+            const __m128i bLayer = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&layers[b]));
+            const __m128i bMask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&masks[b]));
+            const __m128i rejected = _mm_or_si128(
+                _mm_cmpeq_epi32(_mm_and_si128(aLayer, bMask), zero),
+                _mm_cmpeq_epi32(_mm_and_si128(bLayer, aMask), zero));
+
+            const __m128 overlapX = _mm_and_ps(_mm_cmplt_ps(aMinX, _mm_loadu_ps(&maxX[b])), _mm_cmpgt_ps(aMaxX, _mm_loadu_ps(&minX[b])));
+            const __m128 overlapY = _mm_and_ps(_mm_cmplt_ps(aMinY, _mm_loadu_ps(&maxY[b])), _mm_cmpgt_ps(aMaxY, _mm_loadu_ps(&minY[b])));
+
+            const __m128 overlap = _mm_andnot_ps(_mm_castsi128_ps(rejected), _mm_and_ps(overlapX, overlapY));
+
+            for (int mask = _mm_movemask_ps(overlap); mask; mask &= mask - 1) {
+                overlaps.emplace_back(a, b + FindLowestBit(mask));
+            }
+        }
+#endif
+
+        for (; b < numBoxes; b++) {
+            if ((layers[a] & masks[b]) != 0 && (layers[b] & masks[a]) != 0 &&
+                minX[a] < maxX[b] && maxX[a] > minX[b] && minY[a] < maxY[b] && maxY[a] > minY[b]) {
+                overlaps.emplace_back(a, b);
+            }
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef COLLIDERBOUNDS_H
+#define COLLIDERBOUNDS_H
+
+#include "AABB.h"
+#include "CollisionFilter.h"
+#include <cstdint>
+#include <vector>
+
+// Collider boxes in structure of arrays layout, gathered every frame for the narrow phase.
+// The overlap tests run on 8 boxes at a time with AVX2, 4 with SSE2, and one at a time otherwise;
+// the instruction set is picked at compile time (e.g. make SIMD_FLAGS=-mavx2).
+class ColliderBounds {
+private:
+    std::vector<float> minX;
+    std::vector<float> minY;
+    std::vector<float> maxX;
+    std::vector<float> maxY;
+    std::vector<std::uint32_t> layers;
+    std::vector<std::uint32_t> masks;
+
+public:
+    ColliderBounds() = default;
+    ~ColliderBounds() = default;
+
+    void Clear();
+    void Add(const AABB& box, const CollisionFilter& filter);
+    std::size_t GetSize() const { return minX.size(); }
+
+    // Appends the candidate pairs in [begin, end) whose boxes overlap, in candidate order
+    void FindOverlaps(const std::vector<CollisionPair>& candidates, std::size_t begin, std::size_t end, std::vector<CollisionPair>& overlaps) const;
+    void FindOverlaps(const std::vector<CollisionPair>& candidates, std::vector<CollisionPair>& overlaps) const {
+        FindOverlaps(candidates, 0, candidates.size(), overlaps);
+    }
+
+    // Appends every overlapping pair whose filters accept each other, testing each box in [firstBox, lastBox)
+    // against all the boxes after it
+    void FindAllOverlaps(std::size_t firstBox, std::size_t lastBox, std::vector<CollisionPair>& overlaps) const;
+    void FindAllOverlaps(std::vector<CollisionPair>& overlaps) const {
+        FindAllOverlaps(0, GetSize(), overlaps);
+    }
+
+    // Name of the instruction set the tests were compiled for
+    static const char* GetInstructionSet();
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef COLLISIONFILTER_H
+#define COLLISIONFILTER_H
+
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Index of the lowest set bit of a non zero value, layers are single bits so this is also the layer index
+inline int FindLowestBit(std::uint32_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(value);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return static_cast<int>(index);
+#else
+    int index = 0;
+    while (!(value & 1u)) {
+        value >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+// Collision layer bits of a collider and the layers it can collide with
+struct CollisionFilter {
+    std::uint32_t layer;
+    std::uint32_t mask;
+
+    CollisionFilter(std::uint32_t layer = 1, std::uint32_t mask = ~0u) : layer(layer), mask(mask) {}
+
+    // Both colliders have to accept the layer of the other
+    bool CanCollide(const CollisionFilter& other) const {
+        return (layer & other.mask) != 0 && (other.layer & mask) != 0;
+    }
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "ContactCache.h"
+
+ContactCache::ContactCache() {
+    slots.resize(CONTACT_CACHE_INITIAL_CAPACITY, Entry { 0, Entity(0, 0, nullptr), Entity(0, 0, nullptr), 0 });
+}
+
+std::uint64_t ContactCache::GetKey(Entity a, Entity b) {
+    // a has the lower handle, so the larger one makes the key never 0
+    return static_cast<std::uint64_t>(a.GetHandle()) << 32 | b.GetHandle();
+}
+
+std::size_t ContactCache::GetHomeSlot(std::uint64_t key) const {
+    // Finalizer of MurmurHash3, spreads the bits of both handles over the slot index
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key & (slots.size() - 1);
+}
+
+std::size_t ContactCache::FindSlot(std::uint64_t key) const {
+    const std::size_t mask = slots.size() - 1;
+    std::size_t slot = GetHomeSlot(key);
+
+    while (slots[slot].key != 0 && slots[slot].key != key) {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+void ContactCache::EraseSlot(std::size_t slot) {
+    // Backward shift deletion: move back the following entries that would not be found past the hole
+    const std::size_t mask = slots.size() - 1;
+    std::size_t hole = slot;
+    std::size_t next = slot;
+
+    while (true) {
+        next = (next + 1) & mask;
+        if (slots[next].key == 0) {
+            break;
+        }
+
+        // The entry stays if its home slot is cyclically in (hole, next]
+        const std::size_t home = GetHomeSlot(slots[next].key);
+        const bool staysInPlace = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+
+        if (!staysInPlace) {
+            slots[hole] = slots[next];
+            hole = next;
+        }
+    }
+
+    slots[hole].key = 0;
+    numContacts--;
+}
+
+void ContactCache::Grow() {
+    std::vector<Entry> oldSlots(slots.size() * 2, Entry { 0, Entity(0, 0, nullptr), Entity(0, 0, nullptr), 0 });
+    oldSlots.swap(slots);
+
+    for (const auto& entry : oldSlots) {
+        if (entry.key != 0) {
+            slots[FindSlot(entry.key)] = entry;
+        }
+    }
+}
+
+void ContactCache::BeginFrame() {
+    frame++;
+}
+
+bool ContactCache::Touch(Entity a, Entity b) {
+    if (b < a) {
+        std::swap(a, b);
+    }
+
+    const std::uint64_t key = GetKey(a, b);
+    std::size_t slot = FindSlot(key);
+
+    if (slots[slot].key == key) {
+        slots[slot].lastFrame = frame;
+        return false;
+    }
+
+    if (2 * (numContacts + 1) > slots.size()) {
+        Grow();
+        slot = FindSlot(key);
+    }
+
+    slots[slot] = Entry { key, a, b, frame };
+    numContacts++;
+
+    return true;
+}
+
+void ContactCache::Clear() {
+    for (auto& entry : slots) {
+        entry.key = 0;
+    }
+    numContacts = 0;
+}
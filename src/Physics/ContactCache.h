@@ -0,0 +1,89 @@
+#ifndef CONTACTCACHE_H
+#define CONTACTCACHE_H
+
+#include "../ECS/ECS.h"
+#include <cstdint>
+#include <vector>
+
+// Initial number of slots of the contact table, it doubles when it gets more than half full
+const std::size_t CONTACT_CACHE_INITIAL_CAPACITY = 256;
+
+// Whether a contact started in this frame or was already there in the last one
+enum ContactState {
+    CONTACT_ENTER,
+    CONTACT_STAY
+};
+
+// Pair of entities touching in the current frame, a has the lower entity id
+struct Contact {
+    Entity a;
+    Entity b;
+    ContactState state;
+};
+
+// Remembers the pairs of entities that were touching in the last frame, so the collision system
+// can tell new contacts from ongoing ones and from the ones that just ended.
+// Contacts live in a flat open addressing table with linear probing, keyed by the two entity
+// handles; the table and the scratch buffers keep their memory from one frame to the next.
+class ContactCache {
+private:
+    struct Entry {
+        std::uint64_t key; // 0 marks an empty slot
+        Entity a;
+        Entity b;
+        int lastFrame;
+    };
+
+    std::vector<Entry> slots;
+    std::size_t numContacts = 0;
+    int frame = 0;
+
+    // Keys of the contacts that ended, collected before they are erased
+    std::vector<std::uint64_t> endedKeys;
+
+    static std::uint64_t GetKey(Entity a, Entity b);
+    std::size_t GetHomeSlot(std::uint64_t key) const;
+    std::size_t FindSlot(std::uint64_t key) const;
+    void EraseSlot(std::size_t slot);
+    void Grow();
+
+public:
+    ContactCache();
+    ~ContactCache() = default;
+
+    // Starts a new frame, every contact has to be touched again to stay alive
+    void BeginFrame();
+
+    // Records that a and b touch in this frame, returns true if they were not touching in the last frame
+    bool Touch(Entity a, Entity b);
+
+    // Removes the contacts that were not touched in this frame and calls onEnded(a, b) for each of them
+    template <typename TFunc>
+    void EndFrame(TFunc onEnded);
+
+    std::size_t GetSize() const { return numContacts; }
+    void Clear();
+};
+
+template <typename TFunc>
+void ContactCache::EndFrame(TFunc onEnded) {
+    endedKeys.clear();
+
+    for (const auto& entry : slots) {
+        if (entry.key != 0 && entry.lastFrame != frame) {
+            endedKeys.push_back(entry.key);
+        }
+    }
+
+    // Erasing shifts the following entries back, so the slots are looked up again by key
+    for (const auto key : endedKeys) {
+        const std::size_t slot = FindSlot(key);
+        const Entity a = slots[slot].a;
+        const Entity b = slots[slot].b;
+
+        EraseSlot(slot);
+        onEnded(a, b);
+    }
+}
+
+#endif
@@ -0,0 +1,231 @@
+#include "DynamicAABBTree.h"
+
+int DynamicAABBTree::AllocateNode() {
+    int node;
+
+    if (freeList == -1) {
+        node = nodes.size();
+        nodes.emplace_back();
+    } else {
+        node = freeList;
+        freeList = nodes[node].parent;
+    }
+
+    nodes[node].parent = -1;
+    nodes[node].child1 = -1;
+    nodes[node].child2 = -1;
+    nodes[node].height = 0;
+    nodes[node].userData = -1;
+    return node;
+}
+
+void DynamicAABBTree::FreeNode(int node) {
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+int DynamicAABBTree::CreateProxy(const AABB& box, int userData) {
+    const int proxy = AllocateNode();
+
+    nodes[proxy].box = AABB(box.minX - AABB_TREE_FAT_MARGIN, box.minY - AABB_TREE_FAT_MARGIN,
+                            box.maxX + AABB_TREE_FAT_MARGIN, box.maxY + AABB_TREE_FAT_MARGIN);
+    nodes[proxy].userData = userData;
+    InsertLeaf(proxy);
+    numProxies++;
+
+    return proxy;
+}
+
+void DynamicAABBTree::DestroyProxy(int proxy) {
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    numProxies--;
+}
+
+bool DynamicAABBTree::MoveProxy(int proxy, const AABB& box, glm::vec2 displacement) {
+    if (nodes[proxy].box.Contains(box)) {
+        return false;
+    }
+
+    // Stretch the new fat box in the direction of motion, the proxy will likely keep moving that way
+    AABB fatBox(box.minX - AABB_TREE_FAT_MARGIN, box.minY - AABB_TREE_FAT_MARGIN,
+                box.maxX + AABB_TREE_FAT_MARGIN, box.maxY + AABB_TREE_FAT_MARGIN);
+    const glm::vec2 stretch = AABB_TREE_DISPLACEMENT_MULTIPLIER * displacement;
+
+    if (stretch.x < 0) fatBox.minX += stretch.x; else fatBox.maxX += stretch.x;
+    if (stretch.y < 0) fatBox.minY += stretch.y; else fatBox.maxY += stretch.y;
+
+    RemoveLeaf(proxy);
+    nodes[proxy].box = fatBox;
+    InsertLeaf(proxy);
+
+    return true;
+}
+
+void DynamicAABBTree::InsertLeaf(int leaf) {
+    if (root == -1) {
+        root = leaf;
+        nodes[root].parent = -1;
+        return;
+    }
+
+    // Find the best sibling: descend while the cost of going down is lower than pairing here
+    const AABB leafBox = nodes[leaf].box;
+    int index = root;
+
+    while (!nodes[index].IsLeaf()) {
+        const int child1 = nodes[index].child1;
+        const int child2 = nodes[index].child2;
+
+        const float area = nodes[index].box.GetPerimeter();
+        const float combinedArea = AABB::Combine(nodes[index].box, leafBox).GetPerimeter();
+
+        // Cost of creating a new parent for this node and the new leaf
+        const float cost = 2 * combinedArea;
+
+        // Minimum cost of pushing the leaf further down the tree
+        const float inheritanceCost = 2 * (combinedArea - area);
+
+        float childCost[2];
+        const int children[2] = {child1, child2};
+        for (int i = 0; i < 2; i++) {
+            const AABB& childBox = nodes[children[i]].box;
+            const float childCombinedArea = AABB::Combine(leafBox, childBox).GetPerimeter();
+
+            if (nodes[children[i]].IsLeaf()) {
+                childCost[i] = childCombinedArea + inheritanceCost;
+            } else {
+                childCost[i] = childCombinedArea - childBox.GetPerimeter() + inheritanceCost;
+            }
+        }
+
+        if (cost < childCost[0] && cost < childCost[1]) {
+            break;
+        }
+
+        index = childCost[0] < childCost[1] ? child1 : child2;
+    }
+
+    const int sibling = index;
+
+    // Create a new parent for the sibling and the leaf
+    const int oldParent = nodes[sibling].parent;
+    const int newParent = AllocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = AABB::Combine(leafBox, nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent == -1) {
+        root = newParent;
+    } else if (nodes[oldParent].child1 == sibling) {
+        nodes[oldParent].child1 = newParent;
+    } else {
+        nodes[oldParent].child2 = newParent;
+    }
+
+    FixUpwards(nodes[leaf].parent);
+}
+
+void DynamicAABBTree::RemoveLeaf(int leaf) {
+    if (leaf == root) {
+        root = -1;
+        return;
+    }
+
+    const int parent = nodes[leaf].parent;
+    const int grandParent = nodes[parent].parent;
+    const int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    // The sibling takes the place of the parent
+    if (grandParent == -1) {
+        root = sibling;
+        nodes[sibling].parent = -1;
+        FreeNode(parent);
+        return;
+    }
+
+    if (nodes[grandParent].child1 == parent) {
+        nodes[grandParent].child1 = sibling;
+    } else {
+        nodes[grandParent].child2 = sibling;
+    }
+    nodes[sibling].parent = grandParent;
+    FreeNode(parent);
+
+    FixUpwards(grandParent);
+}
+
+void DynamicAABBTree::FixUpwards(int node) {
+    while (node != -1) {
+        node = Balance(node);
+
+        const int child1 = nodes[node].child1;
+        const int child2 = nodes[node].child2;
+        nodes[node].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        nodes[node].box = AABB::Combine(nodes[child1].box, nodes[child2].box);
+
+        node = nodes[node].parent;
+    }
+}
+
+// If a child of node A is two levels taller than the other, rotates it up. Returns the new subtree root
+int DynamicAABBTree::Balance(int iA) {
+    TreeNode* A = &nodes[iA];
+    if (A->IsLeaf() || A->height < 2) {
+        return iA;
+    }
+
+    const int iB = A->child1;
+    const int iC = A->child2;
+    const int balance = nodes[iC].height - nodes[iB].height;
+
+    if (balance >= -1 && balance <= 1) {
+        return iA;
+    }
+
+    // Rotate the taller child P up, its taller child stays under P and the shorter one moves to A
+    const int iP = balance > 1 ? iC : iB;
+    const int iQ = balance > 1 ? iB : iC;
+    TreeNode* P = &nodes[iP];
+    const int iF = P->child1;
+    const int iG = P->child2;
+    TreeNode* F = &nodes[iF];
+    TreeNode* G = &nodes[iG];
+
+    // Swap A and P
+    P->child1 = iA;
+    P->parent = A->parent;
+    A->parent = iP;
+
+    if (P->parent == -1) {
+        root = iP;
+    } else if (nodes[P->parent].child1 == iA) {
+        nodes[P->parent].child1 = iP;
+    } else {
+        nodes[P->parent].child2 = iP;
+    }
+
+    const int iTall = F->height > G->height ? iF : iG;
+    const int iShort = F->height > G->height ? iG : iF;
+    P->child2 = iTall;
+
+    if (balance > 1) {
+        A->child2 = iShort;
+    } else {
+        A->child1 = iShort;
+    }
+    nodes[iShort].parent = iA;
+
+    const TreeNode& Q = nodes[iQ];
+    A->box = AABB::Combine(Q.box, nodes[iShort].box);
+    A->height = 1 + std::max(Q.height, nodes[iShort].height);
+    P->box = AABB::Combine(A->box, nodes[iTall].box);
+    P->height = 1 + std::max(A->height, nodes[iTall].height);
+
+    return iP;
+}
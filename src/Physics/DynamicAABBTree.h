@@ -0,0 +1,220 @@
+#ifndef DYNAMICAABBTREE_H
+#define DYNAMICAABBTREE_H
+
+#include "AABB.h"
+#include <glm/glm.hpp>
+#include <utility>
+#include <vector>
+
+// Margin added around the boxes stored in the tree, so small moves don't need a reinsertion
+const float AABB_TREE_FAT_MARGIN = 4.0f;
+
+// The fat box is also stretched this many times the displacement in the direction of motion
+const float AABB_TREE_DISPLACEMENT_MULTIPLIER = 2.0f;
+
+// Dynamic bounding volume tree: leaves hold fattened boxes of the proxies and every inner node
+// holds the union of its two children. Inserts pick the sibling with the smallest perimeter cost
+// and rotations keep the tree balanced, so queries stay logarithmic whatever the box sizes are.
+class DynamicAABBTree {
+private:
+    struct TreeNode {
+        AABB box;
+        int parent; // next free node when the node is in the free list
+        int child1;
+        int child2;
+        int height; // leaves are 0, free nodes -1
+        int userData;
+
+        bool IsLeaf() const { return child1 == -1; }
+    };
+
+    std::vector<TreeNode> nodes;
+    int root = -1;
+    int freeList = -1;
+    int numProxies = 0;
+
+    // Traversal stack reused by the queries
+    mutable std::vector<int> stack;
+    mutable std::vector<std::pair<int, int>> pairStack;
+
+    int AllocateNode();
+    void FreeNode(int node);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    int Balance(int node);
+    void FixUpwards(int node);
+
+public:
+    DynamicAABBTree() = default;
+    ~DynamicAABBTree() = default;
+
+    // Adds a box to the tree and returns its proxy id
+    int CreateProxy(const AABB& box, int userData);
+    void DestroyProxy(int proxy);
+
+    // Updates the box of a proxy, it is reinserted only if the box left its fat box. Returns true when reinserted
+    bool MoveProxy(int proxy, const AABB& box, glm::vec2 displacement);
+
+    const AABB& GetFatAABB(int proxy) const { return nodes[proxy].box; }
+    int GetUserData(int proxy) const { return nodes[proxy].userData; }
+    void SetUserData(int proxy, int userData) { nodes[proxy].userData = userData; }
+    int GetNumProxies() const { return numProxies; }
+    int GetHeight() const { return root == -1 ? 0 : nodes[root].height; }
+
+    // Calls callback(proxy) for every proxy whose fat box overlaps the box, stops when it returns false
+    template <typename TCallback>
+    void Query(const AABB& box, TCallback callback) const;
+
+    // Calls callback(proxy, maxFraction) for every proxy whose fat box is crossed by the segment from p1 to p2.
+    // The callback returns the new max fraction of the segment: 0 ends the query, a smaller value clips it
+    template <typename TCallback>
+    void RayCast(glm::vec2 p1, glm::vec2 p2, TCallback callback) const;
+
+    // Calls callback(proxyA, proxyB) once for every pair of proxies of this tree whose fat boxes overlap
+    template <typename TCallback>
+    void QueryPairs(TCallback callback) const;
+
+    // Calls callback(proxy, otherProxy) for every proxy of this tree overlapping a proxy of the other tree
+    template <typename TCallback>
+    void QueryPairs(const DynamicAABBTree& other, TCallback callback) const;
+};
+
+template <typename TCallback>
+void DynamicAABBTree::Query(const AABB& box, TCallback callback) const {
+    if (root == -1) {
+        return;
+    }
+
+    stack.clear();
+    stack.push_back(root);
+
+    while (!stack.empty()) {
+        const int nodeId = stack.back();
+        const TreeNode& node = nodes[nodeId];
+        stack.pop_back();
+
+        if (!node.box.Overlaps(box)) {
+            continue;
+        }
+
+        if (node.IsLeaf()) {
+            if (!callback(nodeId)) {
+                return;
+            }
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+template <typename TCallback>
+void DynamicAABBTree::RayCast(glm::vec2 p1, glm::vec2 p2, TCallback callback) const {
+    if (root == -1) {
+        return;
+    }
+
+    const glm::vec2 delta = p2 - p1;
+    float maxFraction = 1.0f;
+
+    stack.clear();
+    stack.push_back(root);
+
+    while (!stack.empty()) {
+        const int nodeId = stack.back();
+        const TreeNode& node = nodes[nodeId];
+        stack.pop_back();
+
+        float fraction;
+        if (!node.box.IntersectsSegment(p1, delta, maxFraction, fraction)) {
+            continue;
+        }
+
+        if (node.IsLeaf()) {
+            maxFraction = callback(nodeId, maxFraction);
+            if (maxFraction <= 0) {
+                return;
+            }
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+template <typename TCallback>
+void DynamicAABBTree::QueryPairs(TCallback callback) const {
+    if (root == -1) {
+        return;
+    }
+
+    // (node, node) finds the pairs inside a subtree, (a, b) the pairs between two disjoint subtrees
+    pairStack.clear();
+    pairStack.emplace_back(root, root);
+
+    while (!pairStack.empty()) {
+        const auto [a, b] = pairStack.back();
+        pairStack.pop_back();
+
+        const TreeNode& nodeA = nodes[a];
+        const TreeNode& nodeB = nodes[b];
+
+        if (a == b) {
+            if (!nodeA.IsLeaf()) {
+                pairStack.emplace_back(nodeA.child1, nodeA.child1);
+                pairStack.emplace_back(nodeA.child2, nodeA.child2);
+                pairStack.emplace_back(nodeA.child1, nodeA.child2);
+            }
+            continue;
+        }
+
+        if (!nodeA.box.Overlaps(nodeB.box)) {
+            continue;
+        }
+
+        if (nodeA.IsLeaf() && nodeB.IsLeaf()) {
+            callback(a, b);
+        } else if (nodeB.IsLeaf() || (!nodeA.IsLeaf() && nodeA.box.GetPerimeter() >= nodeB.box.GetPerimeter())) {
+            // Descend into the larger node
+            pairStack.emplace_back(nodeA.child1, b);
+            pairStack.emplace_back(nodeA.child2, b);
+        } else {
+            pairStack.emplace_back(a, nodeB.child1);
+            pairStack.emplace_back(a, nodeB.child2);
+        }
+    }
+}
+
+template <typename TCallback>
+void DynamicAABBTree::QueryPairs(const DynamicAABBTree& other, TCallback callback) const {
+    if (root == -1 || other.root == -1) {
+        return;
+    }
+
+    pairStack.clear();
+    pairStack.emplace_back(root, other.root);
+
+    while (!pairStack.empty()) {
+        const auto [a, b] = pairStack.back();
+        pairStack.pop_back();
+
+        const TreeNode& nodeA = nodes[a];
+        const TreeNode& nodeB = other.nodes[b];
+
+        if (!nodeA.box.Overlaps(nodeB.box)) {
+            continue;
+        }
+
+        if (nodeA.IsLeaf() && nodeB.IsLeaf()) {
+            callback(a, b);
+        } else if (nodeB.IsLeaf() || (!nodeA.IsLeaf() && nodeA.box.GetPerimeter() >= nodeB.box.GetPerimeter())) {
+            pairStack.emplace_back(nodeA.child1, b);
+            pairStack.emplace_back(nodeA.child2, b);
+        } else {
+            pairStack.emplace_back(a, nodeB.child1);
+            pairStack.emplace_back(a, nodeB.child2);
+        }
+    }
+}
+
+#endif
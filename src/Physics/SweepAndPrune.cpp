@@ -0,0 +1,159 @@
+#include "SweepAndPrune.h"
+
+float SweepAndPrune::GetBound(const AABB& box, int axis, bool isMin) {
+    if (axis == 0) {
+        return isMin ? box.minX : box.maxX;
+    }
+    return isMin ? box.minY : box.maxY;
+}
+
+void SweepAndPrune::UpdateProxies(const std::vector<int>& keys, const std::vector<AABB>& boxes) {
+    for (std::size_t proxy = 0; proxy < proxyKeys.size(); proxy++) {
+        proxyFrameIndices[proxy] = -1;
+    }
+
+    for (int i = 0; i < static_cast<int>(keys.size()); i++) {
+        const int key = keys[i];
+        if (key >= static_cast<int>(keyToProxy.size())) {
+            keyToProxy.resize(key + 1, -1);
+        }
+
+        int proxy = keyToProxy[key];
+        if (proxy == -1) {
+            // New box, its endpoints are appended and the insertion sort moves them into place
+            if (freeProxies.empty()) {
+                proxy = proxyKeys.size();
+                proxyKeys.push_back(key);
+                proxyBoxes.push_back(boxes[i]);
+                proxyFrameIndices.push_back(-1);
+            } else {
+                proxy = freeProxies.back();
+                freeProxies.pop_back();
+                proxyKeys[proxy] = key;
+            }
+            keyToProxy[key] = proxy;
+
+            for (auto& axisEndpoints : endpoints) {
+                axisEndpoints.push_back(Endpoint { 0, proxy << 1 | 1 });
+                axisEndpoints.push_back(Endpoint { 0, proxy << 1 });
+            }
+        }
+
+        proxyBoxes[proxy] = boxes[i];
+        proxyFrameIndices[proxy] = i;
+    }
+
+    // Remove the boxes that are gone
+    bool hasRemovedProxies = false;
+
+    for (std::size_t proxy = 0; proxy < proxyKeys.size(); proxy++) {
+        if (proxyKeys[proxy] != -1 && proxyFrameIndices[proxy] == -1) {
+            keyToProxy[proxyKeys[proxy]] = -1;
+            proxyKeys[proxy] = -1;
+            freeProxies.push_back(proxy);
+            hasRemovedProxies = true;
+        }
+    }
+
+    if (hasRemovedProxies) {
+        for (auto& axisEndpoints : endpoints) {
+            axisEndpoints.erase(std::remove_if(axisEndpoints.begin(), axisEndpoints.end(), [this](const Endpoint& endpoint) {
+                return proxyKeys[endpoint.GetProxy()] == -1;
+            }), axisEndpoints.end());
+        }
+    }
+}
+
+void SweepAndPrune::SortEndpoints(int axis) {
+    auto& axisEndpoints = endpoints[axis];
+
+    for (auto& endpoint : axisEndpoints) {
+        endpoint.value = GetBound(proxyBoxes[endpoint.GetProxy()], axis, endpoint.IsMin());
+    }
+
+    // Insertion sort, the list is almost sorted from the previous frame
+    for (std::size_t i = 1; i < axisEndpoints.size(); i++) {
+        const Endpoint endpoint = axisEndpoints[i];
+        std::size_t j = i;
+
+        while (j > 0 && endpoint < axisEndpoints[j - 1]) {
+            axisEndpoints[j] = axisEndpoints[j - 1];
+            j--;
+        }
+
+        axisEndpoints[j] = endpoint;
+        numSwaps += i - j;
+    }
+}
+
+int SweepAndPrune::FindPairs(const std::vector<int>& keys, const std::vector<AABB>& boxes, const std::vector<CollisionFilter>& filters,
+                             std::vector<CollisionPair>& pairs) {
+    UpdateProxies(keys, boxes);
+
+    numSwaps = 0;
+    SortEndpoints(0);
+    SortEndpoints(1);
+
+    // Sweep the axis with the larger spread of box centers, it keeps fewer boxes active at once
+    float sum[2] = {0, 0};
+    float sumSquares[2] = {0, 0};
+
+    for (const auto& box : boxes) {
+        const float center[2] = {(box.minX + box.maxX) / 2, (box.minY + box.maxY) / 2};
+        for (int axis = 0; axis < 2; axis++) {
+            sum[axis] += center[axis];
+            sumSquares[axis] += center[axis] * center[axis];
+        }
+    }
+
+    float variance[2];
+    for (int axis = 0; axis < 2; axis++) {
+        const float mean = boxes.empty() ? 0 : sum[axis] / boxes.size();
+        variance[axis] = boxes.empty() ? 0 : sumSquares[axis] / boxes.size() - mean * mean;
+    }
+
+    const int sweepAxis = variance[0] >= variance[1] ? 0 : 1;
+
+    activeProxies.clear();
+    activeIndices.resize(proxyKeys.size());
+
+    int numPairs = 0;
+
+    for (const auto& endpoint : endpoints[sweepAxis]) {
+        const int proxy = endpoint.GetProxy();
+        const AABB& box = proxyBoxes[proxy];
+
+        // The max endpoint of an empty interval sorts before its min, so it is tested but never active
+        const bool isEmpty = GetBound(box, sweepAxis, false) <= GetBound(box, sweepAxis, true);
+
+        if (!endpoint.IsMin()) {
+            if (isEmpty) {
+                continue;
+            }
+
+            // Swap the last active proxy into the slot of the one that ends here
+            const int indexOfRemoved = activeIndices[proxy];
+            const int lastProxy = activeProxies.back();
+            activeProxies[indexOfRemoved] = lastProxy;
+            activeIndices[lastProxy] = indexOfRemoved;
+            activeProxies.pop_back();
+            continue;
+        }
+
+        const CollisionFilter& filter = filters[proxyFrameIndices[proxy]];
+
+        for (const int activeProxy : activeProxies) {
+            if (filter.CanCollide(filters[proxyFrameIndices[activeProxy]]) && box.Overlaps(proxyBoxes[activeProxy])) {
+                pairs.emplace_back(proxyFrameIndices[proxy], proxyFrameIndices[activeProxy]);
+                numPairs++;
+            }
+        }
+
+        if (!isEmpty) {
+            activeIndices[proxy] = activeProxies.size();
+            activeProxies.push_back(proxy);
+        }
+    }
+
+    return numPairs;
+}
@@ -0,0 +1,60 @@
+#ifndef SWEEPANDPRUNE_H
+#define SWEEPANDPRUNE_H
+
+#include "AABB.h"
+#include "CollisionFilter.h"
+#include <vector>
+
+// Broad phase that keeps the box endpoints of both axes sorted between frames.
+// Boxes are identified by a persistent key (the entity id), so from one frame to the next the
+// endpoints only move a little and an insertion sort repairs the lists in close to linear time.
+// Pairs are found by sweeping the axis where the boxes are more spread out.
+class SweepAndPrune {
+private:
+    struct Endpoint {
+        float value;
+        int data; // proxy << 1, plus 1 for the min endpoint
+
+        int GetProxy() const { return data >> 1; }
+        bool IsMin() const { return data & 1; }
+
+        // On equal values max endpoints go first, so touching boxes are never active together
+        bool operator <(const Endpoint& other) const {
+            return value < other.value || (value == other.value && IsMin() < other.IsMin());
+        }
+    };
+
+    std::vector<Endpoint> endpoints[2];
+
+    // Proxies hold the box of every key, keys are -1 for free proxies
+    std::vector<int> keyToProxy;
+    std::vector<int> proxyKeys;
+    std::vector<AABB> proxyBoxes;
+    std::vector<int> proxyFrameIndices;
+    std::vector<int> freeProxies;
+
+    // Proxies whose interval contains the sweep position
+    std::vector<int> activeProxies;
+    std::vector<int> activeIndices;
+
+    int numSwaps = 0;
+
+    static float GetBound(const AABB& box, int axis, bool isMin);
+    void UpdateProxies(const std::vector<int>& keys, const std::vector<AABB>& boxes);
+    void SortEndpoints(int axis);
+
+public:
+    SweepAndPrune() = default;
+    ~SweepAndPrune() = default;
+
+    // Appends every overlapping pair of boxes whose filters accept each other as indices into boxes,
+    // returns the number of pairs. keys[i] is the persistent key of boxes[i], keys that are missing
+    // since the last call are removed.
+    int FindPairs(const std::vector<int>& keys, const std::vector<AABB>& boxes, const std::vector<CollisionFilter>& filters,
+                  std::vector<CollisionPair>& pairs);
+
+    // Number of endpoint moves done by the last insertion sort, low when the frames are coherent
+    int GetNumSwaps() const { return numSwaps; }
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include "TileCollisionMap.h"
+#include <algorithm>
+#include <cmath>
+
+void TileCollisionMap::Configure(int numCols, int numRows, float tileSize) {
+    this->numCols = std::max(numCols, 0);
+    this->numRows = std::max(numRows, 0);
+    this->tileSize = tileSize;
+    wordsPerRow = (this->numCols + 63) / 64;
+    numSolidTiles = 0;
+    bits.assign(wordsPerRow * this->numRows, 0);
+}
+
+void TileCollisionMap::SetSolid(int col, int row, bool solid) {
+    if (col < 0 || col >= numCols || row < 0 || row >= numRows) {
+        return;
+    }
+
+    std::uint64_t& word = bits[row * wordsPerRow + col / 64];
+    const std::uint64_t bit = std::uint64_t(1) << (col % 64);
+
+    if (solid != ((word & bit) != 0)) {
+        word ^= bit;
+        numSolidTiles += solid ? 1 : -1;
+    }
+}
+
+bool TileCollisionMap::IsSolid(int col, int row) const {
+    if (col < 0 || col >= numCols || row < 0 || row >= numRows) {
+        return false;
+    }
+    return (bits[row * wordsPerRow + col / 64] >> (col % 64)) & 1;
+}
+
+bool TileCollisionMap::GetTileRange(const AABB& box, int& firstCol, int& firstRow, int& lastCol, int& lastRow) const {
+    // A tile is overlapped if the box goes past its edges, so the last tile is the one before the ceiling
+    firstCol = std::max(static_cast<int>(std::floor(box.minX / tileSize)), 0);
+    firstRow = std::max(static_cast<int>(std::floor(box.minY / tileSize)), 0);
+    lastCol = std::min(static_cast<int>(std::ceil(box.maxX / tileSize)) - 1, numCols - 1);
+    lastRow = std::min(static_cast<int>(std::ceil(box.maxY / tileSize)) - 1, numRows - 1);
+
+    return firstCol <= lastCol && firstRow <= lastRow;
+}
+
+bool TileCollisionMap::IsRowSolid(int row, int firstCol, int lastCol) const {
+    const std::uint64_t* words = &bits[row * wordsPerRow];
+    const int firstWord = firstCol / 64;
+    const int lastWord = lastCol / 64;
+
+    for (int w = firstWord; w <= lastWord; w++) {
+        std::uint64_t mask = ~std::uint64_t(0);
+        if (w == firstWord) {
+            mask &= ~std::uint64_t(0) << (firstCol % 64);
+        }
+        if (w == lastWord) {
+            mask &= ~std::uint64_t(0) >> (63 - lastCol % 64);
+        }
+        if (words[w] & mask) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TileCollisionMap::IsColumnSolid(int col, int firstRow, int lastRow) const {
+    const std::uint64_t bit = std::uint64_t(1) << (col % 64);
+
+    for (int row = firstRow; row <= lastRow; row++) {
+        if (bits[row * wordsPerRow + col / 64] & bit) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TileCollisionMap::Overlaps(const AABB& box) const {
+    if (numSolidTiles == 0) {
+        return false;
+    }
+
+    int firstCol, firstRow, lastCol, lastRow;
+    if (!GetTileRange(box, firstCol, firstRow, lastCol, lastRow)) {
+        return false;
+    }
+
+    for (int row = firstRow; row <= lastRow; row++) {
+        if (IsRowSolid(row, firstCol, lastCol)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+float TileCollisionMap::SweepAxis(const AABB& box, int axis, float delta, bool& hit) const {
+    hit = false;
+
+    if (delta == 0 || numSolidTiles == 0) {
+        return delta;
+    }
+
+    // Tiles crossed by the side of the box, along the other axis
+    AABB side = box;
+    if (axis == 0) {
+        side.minX = 0;
+        side.maxX = numCols * tileSize;
+    } else {
+        side.minY = 0;
+        side.maxY = numRows * tileSize;
+    }
+
+    int firstCol, firstRow, lastCol, lastRow;
+    if (!GetTileRange(side, firstCol, firstRow, lastCol, lastRow)) {
+        return delta;
+    }
+
+    const int numLines = axis == 0 ? numCols : numRows;
+    const float boxMin = axis == 0 ? box.minX : box.minY;
+    const float boxMax = axis == 0 ? box.maxX : box.maxY;
+
+    auto isLineSolid = [&](int line) {
+        return axis == 0 ? IsColumnSolid(line, firstRow, lastRow) : IsRowSolid(line, firstCol, lastCol);
+    };
+
+    if (delta > 0) {
+        // Lines of tiles ahead of the leading edge, up to the one the edge ends in
+        const int first = std::max(static_cast<int>(std::ceil(boxMax / tileSize)), 0);
+        const int last = std::min(static_cast<int>(std::ceil((boxMax + delta) / tileSize)) - 1, numLines - 1);
+
+        for (int line = first; line <= last; line++) {
+            if (isLineSolid(line)) {
+                hit = true;
+                return std::max(line * tileSize - boxMax, 0.0f);
+            }
+        }
+    } else {
+        const int first = std::min(static_cast<int>(std::floor(boxMin / tileSize)) - 1, numLines - 1);
+        const int last = std::max(static_cast<int>(std::floor((boxMin + delta) / tileSize)), 0);
+
+        for (int line = first; line >= last; line--) {
+            if (isLineSolid(line)) {
+                hit = true;
+                return std::min((line + 1) * tileSize - boxMin, 0.0f);
+            }
+        }
+    }
+
+    return delta;
+}
+
+glm::vec2 TileCollisionMap::Sweep(const AABB& box, glm::vec2 delta, bool& hitX, bool& hitY) const {
+    const float moveX = SweepAxis(box, 0, delta.x, hitX);
+    const AABB movedBox(box.minX + moveX, box.minY, box.maxX + moveX, box.maxY);
+    const float moveY = SweepAxis(movedBox, 1, delta.y, hitY);
+
+    return glm::vec2(moveX, moveY);
+}
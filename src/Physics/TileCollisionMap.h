@@ -0,0 +1,57 @@
+#ifndef TILECOLLISIONMAP_H
+#define TILECOLLISIONMAP_H
+
+#include "AABB.h"
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Solid tiles of the tilemap, one bit per tile, so the static world never goes through the broad phase.
+// Every row starts on a new 64 bit word, a box test checks a whole run of tiles with a few masks.
+// Tiles outside of the map are not solid.
+class TileCollisionMap {
+private:
+    int numCols = 0;
+    int numRows = 0;
+    int wordsPerRow = 0;
+    float tileSize = 1;
+    int numSolidTiles = 0;
+    std::vector<std::uint64_t> bits;
+
+    // Tiles overlapped by the box clamped to the map, returns false if there are none
+    bool GetTileRange(const AABB& box, int& firstCol, int& firstRow, int& lastCol, int& lastRow) const;
+
+    // Whether any tile between firstCol and lastCol (inclusive) of the row is solid
+    bool IsRowSolid(int row, int firstCol, int lastCol) const;
+
+    // Whether any tile between firstRow and lastRow (inclusive) of the column is solid
+    bool IsColumnSolid(int col, int firstRow, int lastRow) const;
+
+    // Moves the box along one axis (0 for x, 1 for y) and returns how far it could go
+    float SweepAxis(const AABB& box, int axis, float delta, bool& hit) const;
+
+public:
+    TileCollisionMap() = default;
+    ~TileCollisionMap() = default;
+
+    // Resizes the map and clears every tile, tileSize is the size of a tile in world units
+    void Configure(int numCols, int numRows, float tileSize);
+
+    void SetSolid(int col, int row, bool solid);
+    bool IsSolid(int col, int row) const;
+
+    int GetNumCols() const { return numCols; }
+    int GetNumRows() const { return numRows; }
+    float GetTileSize() const { return tileSize; }
+    int GetNumSolidTiles() const { return numSolidTiles; }
+
+    // Whether the box overlaps a solid tile, touching the edge of a tile does not count
+    bool Overlaps(const AABB& box) const;
+
+    // Moves the box by delta, first along x and then along y, and stops it against the first solid tile
+    // of each axis. Returns the displacement the box could do; hitX and hitY tell which axes were stopped.
+    // Tiles the box already overlaps do not stop it, so a box that starts inside a wall can get out.
+    glm::vec2 Sweep(const AABB& box, glm::vec2 delta, bool& hitX, bool& hitY) const;
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "UniformGrid.h"
+#include <cmath>
+
+void UniformGrid::Configure(float worldWidth, float worldHeight, float cellSize) {
+    this->cellSize = cellSize;
+    numCols = std::max(1, static_cast<int>(std::ceil(worldWidth / cellSize)));
+    numRows = std::max(1, static_cast<int>(std::ceil(worldHeight / cellSize)));
+}
+
+int UniformGrid::GetCol(float x) const {
+    return std::min(std::max(static_cast<int>(std::floor(x / cellSize)), 0), numCols - 1);
+}
+
+int UniformGrid::GetRow(float y) const {
+    return std::min(std::max(static_cast<int>(std::floor(y / cellSize)), 0), numRows - 1);
+}
+
+void UniformGrid::Build(const std::vector<AABB>& boxes) {
+    const int numCells = GetNumCells();
+    cellStarts.assign(numCells + 1, 0);
+
+    // Count the boxes of every cell
+    for (const auto& box : boxes) {
+        const int minCol = GetCol(box.minX), maxCol = GetCol(box.maxX);
+        const int minRow = GetRow(box.minY), maxRow = GetRow(box.maxY);
+
+        for (int row = minRow; row <= maxRow; row++) {
+            for (int col = minCol; col <= maxCol; col++) {
+                cellStarts[row * numCols + col + 1]++;
+            }
+        }
+    }
+
+    for (int cell = 0; cell < numCells; cell++) {
+        cellStarts[cell + 1] += cellStarts[cell];
+    }
+
+    // Fill the cells in box order, so the boxes of a cell are sorted by index
+    cellEntries.resize(cellStarts[numCells]);
+    cellCursors.assign(cellStarts.begin(), cellStarts.end() - 1);
+
+    for (int i = 0; i < static_cast<int>(boxes.size()); i++) {
+        const auto& box = boxes[i];
+        const int minCol = GetCol(box.minX), maxCol = GetCol(box.maxX);
+        const int minRow = GetRow(box.minY), maxRow = GetRow(box.maxY);
+
+        for (int row = minRow; row <= maxRow; row++) {
+            for (int col = minCol; col <= maxCol; col++) {
+                cellEntries[cellCursors[row * numCols + col]++] = i;
+            }
+        }
+    }
+
+}
+
+int UniformGrid::FindPairsInCells(const std::vector<AABB>& boxes, const std::vector<CollisionFilter>& filters, int firstCell, int lastCell,
+                                  std::vector<CollisionPair>& pairs) const {
+    // Boxes sharing several cells are reported only by the cell holding the corner of their overlap
+    int numPairs = 0;
+
+    for (int cell = firstCell; cell < lastCell; cell++) {
+        const int start = cellStarts[cell];
+        const int end = cellStarts[cell + 1];
+
+        for (int i = start; i < end; i++) {
+            const AABB& a = boxes[cellEntries[i]];
+            const CollisionFilter& filterA = filters[cellEntries[i]];
+
+            for (int j = i + 1; j < end; j++) {
+                if (!filterA.CanCollide(filters[cellEntries[j]])) {
+                    continue;
+                }
+
+                const AABB& b = boxes[cellEntries[j]];
+
+                const int referenceCell = GetRow(std::max(a.minY, b.minY)) * numCols + GetCol(std::max(a.minX, b.minX));
+                if (referenceCell == cell) {
+                    pairs.emplace_back(cellEntries[i], cellEntries[j]);
+                    numPairs++;
+                }
+            }
+        }
+    }
+
+    return numPairs;
+}
+
+int UniformGrid::FindPairs(const std::vector<AABB>& boxes, const std::vector<CollisionFilter>& filters, std::vector<CollisionPair>& pairs) {
+    Build(boxes);
+    return FindPairsInCells(boxes, filters, 0, GetNumCells(), pairs);
+}
@@ -0,0 +1,53 @@
+#ifndef UNIFORMGRID_H
+#define UNIFORMGRID_H
+
+#include "AABB.h"
+#include "CollisionFilter.h"
+#include <vector>
+
+// Default cell size in pixels, a couple of times the size of the usual collider
+const float UNIFORM_GRID_CELL_SIZE = 64.0f;
+
+// Broad phase that buckets the boxes into the cells of a uniform grid covering the world.
+// The buckets are rebuilt every frame with a counting sort, so they are two flat arrays.
+// Boxes outside the world are clamped into the border cells.
+class UniformGrid {
+private:
+    float cellSize = UNIFORM_GRID_CELL_SIZE;
+    int numCols = 1;
+    int numRows = 1;
+
+    // Boxes of cell c are cellEntries[cellStarts[c]] .. cellEntries[cellStarts[c + 1] - 1]
+    std::vector<int> cellStarts;
+    std::vector<int> cellEntries;
+    std::vector<int> cellCursors;
+
+    int GetCol(float x) const;
+    int GetRow(float y) const;
+
+public:
+    UniformGrid() = default;
+    ~UniformGrid() = default;
+
+    // Sizes the grid to cover a world of worldWidth x worldHeight pixels
+    void Configure(float worldWidth, float worldHeight, float cellSize = UNIFORM_GRID_CELL_SIZE);
+
+    // Buckets the boxes into the cells
+    void Build(const std::vector<AABB>& boxes);
+
+    // Appends each pair of boxes that share a cell in [firstCell, lastCell) and whose filters accept
+    // each other once, returns the number of pairs reported. Ranges of cells can run on different threads
+    int FindPairsInCells(const std::vector<AABB>& boxes, const std::vector<CollisionFilter>& filters, int firstCell, int lastCell,
+                         std::vector<CollisionPair>& pairs) const;
+
+    // Builds the grid and finds the pairs of all the cells
+    int FindPairs(const std::vector<AABB>& boxes, const std::vector<CollisionFilter>& filters, std::vector<CollisionPair>& pairs);
+
+    int GetNumCells() const { return numCols * numRows; }
+
+    int GetNumCols() const { return numCols; }
+    int GetNumRows() const { return numRows; }
+    float GetCellSize() const { return cellSize; }
+};
+
+#endif
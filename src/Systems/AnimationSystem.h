@@ -2,6 +2,7 @@
 #define ANIMATIONSYSTEM_H
 
 #include "../ECS/ECS.h"
+#include "../JobSystem/JobSystem.h"
 #include "../Components/SpriteComponent.h"
 #include "../Components/AnimationComponent.h"
 #include <SDL2/SDL.h>
@@ -13,15 +14,15 @@ public:
         RequireComponent<AnimationComponent>();
     }
 
-    void Update() {
-        for (auto entity : GetSystemEntities()) {
-            auto& animation = entity.GetComponent<AnimationComponent>();
-            auto& sprite = entity.GetComponent<SpriteComponent>();
+    void Update(std::unique_ptr<Registry>& registry, std::unique_ptr<JobSystem>& jobSystem) {
+        const Uint32 ticks = SDL_GetTicks();
 
-            animation.currentFrame = (int) ((SDL_GetTicks() - animation.startTime) * animation.frameSpeedRate / 1000.0) % animation.numFrames;
+        jobSystem->ParallelForEach(registry->View<AnimationComponent, SpriteComponent>(),
+            [ticks](Entity, AnimationComponent& animation, SpriteComponent& sprite) {
+                animation.currentFrame = (int) ((ticks - animation.startTime) * animation.frameSpeedRate / 1000.0) % animation.numFrames;
 
-            sprite.srcRect.x = animation.currentFrame * sprite.width;
-        }
+                sprite.srcRect.x = animation.currentFrame * sprite.width;
+            }, "AnimationSystem");
     }
 };
 
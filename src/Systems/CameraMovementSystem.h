@@ -9,8 +9,8 @@
 class CameraMovementSystem : public System {
 public:
     CameraMovementSystem() {
-        RequireComponent<CameraFollowComponent>();
-        RequireComponent<TransformComponent>();
+        RequireComponent<CameraFollowComponent>(ACCESS_READ);
+        RequireComponent<TransformComponent>(ACCESS_READ);
     }
     void Update(SDL_Rect& camera) {
         for (auto entity : GetSystemEntities()) {
@@ -5,67 +5,403 @@
 #include "../Components/BoxColliderComponent.h"
 #include "../Components/TransformComponent.h"
 #include "../EventBus/EventBus.h"
-#include "../Event/CollisionEvent.h"
+#include "../Event/CollisionEnterEvent.h"
+#include "../Event/CollisionExitEvent.h"
+#include "../JobSystem/JobSystem.h"
+#include "../Physics/AABB.h"
+#include "../Physics/UniformGrid.h"
+#include "../Physics/SweepAndPrune.h"
+#include "../Physics/DynamicAABBTree.h"
+#include "../Physics/ColliderBounds.h"
+#include "../Physics/CollisionFilter.h"
+#include "../Physics/ContactCache.h"
+#include "../Physics/TileCollisionMap.h"
+#include <array>
+#include <chrono>
+#include <optional>
+
+// Work given to each job when the pair generation is split across threads
+const std::size_t COLLISION_CELLS_PER_JOB = 64;
+const std::size_t COLLISION_BOXES_PER_JOB = 32;
+const std::size_t COLLISION_PAIRS_PER_JOB = 1024;
+
+// How the system finds the pairs of colliders to test
+enum BroadPhaseMode {
+    BROAD_PHASE_BRUTE_FORCE,
+    BROAD_PHASE_UNIFORM_GRID,
+    BROAD_PHASE_SWEEP_AND_PRUNE,
+    BROAD_PHASE_AABB_TREE
+};
+
+// Counters of the last update, to compare the broad phase modes
+struct CollisionStats {
+    int numColliders = 0;
+    int numCandidatePairs = 0;
+    int numCollisions = 0;
+    int numContactsEntered = 0;
+    int numContactsExited = 0;
+    int numTileContacts = 0;
+    double treeUpdateMs = 0;
+    double broadPhaseMs = 0;
+    double narrowPhaseMs = 0;
+};
+
+// Closest collider hit by a ray cast
+struct RayCastHit {
+    Entity entity;
+    glm::vec2 point;
+    float fraction;
+};
 
 class CollisionSystem : public System {
+private:
+    BroadPhaseMode broadPhaseMode = BROAD_PHASE_UNIFORM_GRID;
+    UniformGrid grid;
+    SweepAndPrune sweepAndPrune;
+
+    // The AABB tree is updated every frame in the tree mode, in the other modes only when a rectangle or ray
+    // query needs it. Proxy user data is the index of the collider in the per frame buffers
+    DynamicAABBTree tree;
+    bool isTreeDirty = false;
+    std::vector<int> treeProxyPerId;
+    std::vector<AABB> treeBoxPerId;
+    std::vector<int> treeUpdatePerId;
+    std::vector<int> treeIds;
+    int numUpdates = 0;
+    CollisionStats stats;
+
+    // Pairs that were touching in the last frame, to tell new contacts from ongoing ones
+    ContactCache contactCache;
+
+    // Contacts of the last update sorted by entity, handed to the systems that react to collisions
+    std::vector<Contact> contacts;
+
+    // Static world geometry, colliders whose mask has LAYER_TILE are stopped by its solid tiles
+    TileCollisionMap tileMap;
+    std::vector<Entity> tileContacts;
+
+    // Box of every collider at the end of the update it was last seen in, the start of its move in the next one.
+    // The generation tells the collider apart from a new entity that reuses its id
+    struct PreviousBox {
+        AABB box;
+        std::uint32_t generation = 0;
+        int update = -1;
+    };
+    std::vector<PreviousBox> previousBoxPerId;
+
+    // Collision matrix: layerMasks[i] has the layers that layer i collides with
+    std::array<std::uint32_t, MAX_COLLISION_LAYERS> layerMasks;
+
+    // Per frame buffers, kept to reuse their memory
+    std::vector<Entity> colliderEntities;
+    std::vector<int> colliderIds;
+    std::vector<AABB> colliderBoxes;
+    std::vector<CollisionFilter> colliderFilters;
+    ColliderBounds colliderBounds;
+    std::vector<CollisionPair> candidatePairs;
+    std::vector<CollisionPair> overlappingPairs;
+
+    // Every thread appends the pairs it finds to its own buffer, merged after the parallel loop
+    std::vector<std::vector<CollisionPair>> threadPairs;
+
+    // Moves the pairs of all the thread buffers to the end of pairs
+    void MergeThreadPairs(std::vector<CollisionPair>& pairs) {
+        for (auto& buffer : threadPairs) {
+            pairs.insert(pairs.end(), buffer.begin(), buffer.end());
+            buffer.clear();
+        }
+    }
+
+    std::uint32_t GetLayerMask(std::uint32_t layer) const {
+        return layer ? layerMasks[FindLowestBit(layer)] : 0;
+    }
+
+    // Moves a box that went into solid tiles back along its path, using the box of the last update as the
+    // start of the move. Returns true if the box was stopped. A collider that has no box in the last update
+    // (it was just created or just got its collider) is left where it is, even inside solid tiles; it is
+    // stopped from its next move on. A teleport is a move too, the box stops at the first tile on its way
+    bool ResolveTileCollision(Entity entity, AABB& box) const {
+        const std::size_t id = entity.GetId();
+        if (id >= previousBoxPerId.size() || previousBoxPerId[id].update != numUpdates - 1 ||
+            previousBoxPerId[id].generation != entity.GetGeneration() || !tileMap.Overlaps(box)) {
+            return false;
+        }
+
+        const AABB& previousBox = previousBoxPerId[id].box;
+        const glm::vec2 delta(box.minX - previousBox.minX, box.minY - previousBox.minY);
+        bool hitX, hitY;
+        const glm::vec2 move = tileMap.Sweep(previousBox, delta, hitX, hitY);
+
+        box = AABB(previousBox.minX + move.x, previousBox.minY + move.y, previousBox.maxX + move.x, previousBox.maxY + move.y);
+        return hitX || hitY;
+    }
+
+    void UpdateTree() {
+        isTreeDirty = false;
+
+        for (int i = 0; i < static_cast<int>(colliderIds.size()); i++) {
+            const int id = colliderIds[i];
+            const AABB& box = colliderBoxes[i];
+
+            if (id >= static_cast<int>(treeProxyPerId.size())) {
+                treeProxyPerId.resize(id + 1, -1);
+                treeBoxPerId.resize(id + 1);
+                treeUpdatePerId.resize(id + 1, 0);
+            }
+
+            if (treeProxyPerId[id] == -1) {
+                treeProxyPerId[id] = tree.CreateProxy(box, i);
+                treeIds.push_back(id);
+            } else {
+                const AABB& previousBox = treeBoxPerId[id];
+                tree.MoveProxy(treeProxyPerId[id], box, glm::vec2(box.minX - previousBox.minX, box.minY - previousBox.minY));
+                tree.SetUserData(treeProxyPerId[id], i);
+            }
+
+            treeBoxPerId[id] = box;
+            treeUpdatePerId[id] = numUpdates;
+        }
+
+        // Remove the proxies of the entities that are no longer colliders
+        for (std::size_t i = 0; i < treeIds.size();) {
+            const int id = treeIds[i];
+
+            if (treeUpdatePerId[id] != numUpdates) {
+                tree.DestroyProxy(treeProxyPerId[id]);
+                treeProxyPerId[id] = -1;
+                treeIds[i] = treeIds.back();
+                treeIds.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+
 public:
     CollisionSystem() {
-        RequireComponent<TransformComponent>();
-        RequireComponent<BoxColliderComponent>();
+        layerMasks.fill(LAYER_MASK_ALL);
+
+        RequireComponent<TransformComponent>(ACCESS_WRITE);
+        RequireComponent<BoxColliderComponent>(ACCESS_READ);
+
+        // Collision handlers can damage and kill any entity
+        RequireExclusiveAccess();
     }
 
-    void Update(std::unique_ptr<EventBus>& eventBus)  {
-        auto entities = GetSystemEntities();
+    void SetBroadPhase(BroadPhaseMode mode) { broadPhaseMode = mode; }
+    BroadPhaseMode GetBroadPhase() const { return broadPhaseMode; }
+    const CollisionStats& GetStats() const { return stats; }
 
-        // loop all the entities that the system is interested in
-        for (auto i = entities.begin(); i != entities.end(); ++i) {
-            Entity a = *i;
+    // Contacts found by the last update, sorted by the ids of a and then b; valid until the next update
+    const std::vector<Contact>& GetContacts() const { return contacts; }
 
-            auto aTransform = a.GetComponent<TransformComponent>();
-            auto aCollider = a.GetComponent<BoxColliderComponent>();
+    // Entities stopped by a solid tile in the last update, in collider order
+    const std::vector<Entity>& GetTileContacts() const { return tileContacts; }
 
-            // loop all the entities that still need to be checked ->
-            for (auto j = i; j != entities.end(); ++j) {
-                Entity b = *j;
+    // Solid tiles of the level, filled when the tilemap is loaded
+    TileCollisionMap& GetTileMap() { return tileMap; }
+    const TileCollisionMap& GetTileMap() const { return tileMap; }
 
-                // bypass if we are trying to test the same entity
-                if (a == b) {
-                    continue;
-                }
+    // Enables or disables the collisions between two layers in the collision matrix
+    void SetLayersCollide(CollisionLayer layerA, CollisionLayer layerB, bool collide) {
+        const int indexA = FindLowestBit(layerA);
+        const int indexB = FindLowestBit(layerB);
 
-                auto bTransform = b.GetComponent<TransformComponent>();
-                auto bCollider = b.GetComponent<BoxColliderComponent>();
+        if (collide) {
+            layerMasks[indexA] |= layerB;
+            layerMasks[indexB] |= layerA;
+        } else {
+            layerMasks[indexA] &= ~static_cast<std::uint32_t>(layerB);
+            layerMasks[indexB] &= ~static_cast<std::uint32_t>(layerA);
+        }
+    }
+
+    // Sizes the broad phase structures to the map, colliders outside of it still collide
+    void SetWorldBounds(int worldWidth, int worldHeight) {
+        grid.Configure(worldWidth, worldHeight);
+    }
+
+    void Update(std::unique_ptr<JobSystem>& jobSystem, std::unique_ptr<EventBus>& eventBus)  {
+        const auto startTime = std::chrono::steady_clock::now();
+        numUpdates++;
+
+        // Gather the boxes once, the pair tests only read these arrays
+        colliderEntities.clear();
+        colliderIds.clear();
+        colliderBoxes.clear();
+        colliderFilters.clear();
+        colliderBounds.Clear();
+        candidatePairs.clear();
+        overlappingPairs.clear();
+        tileContacts.clear();
+        threadPairs.resize(jobSystem->GetNumThreads());
 
-                 // Perform the AABB collision check between entities a and b
-                 bool collisionHappened = CheckAABBCollision(
-                    aTransform.position.x + aCollider.offset.x,
-                    aTransform.position.y + aCollider.offset.y,
-                    aCollider.width,
-                    aCollider.height,
-                    bTransform.position.x + bCollider.offset.x,
-                    bTransform.position.y + bCollider.offset.y,
-                    bCollider.width,
-                    bCollider.height
-                 );
+        for (auto entity : GetSystemEntities()) {
+            auto& transform = entity.GetComponent<TransformComponent>();
+            const auto& collider = entity.GetComponent<BoxColliderComponent>();
 
-                if (collisionHappened) {
-                    Logger::Log("Entity " + std::to_string(a.GetId()) + " is colliding with " + std::to_string(b.GetId()));
+            const float x = transform.position.x + collider.offset.x;
+            const float y = transform.position.y + collider.offset.y;
+            AABB box(x, y, x + collider.width, y + collider.height);
 
-                    // emit event
-                    eventBus->EmitEvent<CollisionEvent>(a, b);
+            // The collider mask is narrowed down by the collision matrix row of its layer
+            const CollisionFilter filter(collider.layer, collider.mask & GetLayerMask(collider.layer));
 
-                }
+            // Walls are tested against the tile bitmap before the broad phase, so they never become pairs
+            if ((filter.mask & LAYER_TILE) && ResolveTileCollision(entity, box)) {
+                transform.position.x += box.minX - x;
+                transform.position.y += box.minY - y;
+                tileContacts.push_back(entity);
             }
+
+            if (static_cast<std::size_t>(entity.GetId()) >= previousBoxPerId.size()) {
+                previousBoxPerId.resize(entity.GetId() + 1);
+            }
+            previousBoxPerId[entity.GetId()] = PreviousBox { box, entity.GetGeneration(), numUpdates };
+
+            colliderEntities.push_back(entity);
+            colliderIds.push_back(entity.GetId());
+            colliderBoxes.push_back(box);
+            colliderFilters.push_back(filter);
+            colliderBounds.Add(box, filter);
+        }
+
+        isTreeDirty = true;
+        if (broadPhaseMode == BROAD_PHASE_AABB_TREE) {
+            UpdateTree();
         }
+
+        const auto treeUpdateTime = std::chrono::steady_clock::now();
+
+        switch (broadPhaseMode) {
+            case BROAD_PHASE_BRUTE_FORCE:
+                // Every pair is a candidate, the narrow phase tests them straight from the bounds arrays
+                break;
+            case BROAD_PHASE_UNIFORM_GRID:
+                // The cells are independent, so ranges of cells are processed in parallel
+                grid.Build(colliderBoxes);
+                jobSystem->ParallelFor(grid.GetNumCells(), COLLISION_CELLS_PER_JOB, [this](std::size_t begin, std::size_t end) {
+                    grid.FindPairsInCells(colliderBoxes, colliderFilters, begin, end, threadPairs[JobSystem::GetThreadIndex()]);
+                }, "CollisionSystem::Grid");
+                MergeThreadPairs(candidatePairs);
+                break;
+            case BROAD_PHASE_SWEEP_AND_PRUNE:
+                sweepAndPrune.FindPairs(colliderIds, colliderBoxes, colliderFilters, candidatePairs);
+                break;
+            case BROAD_PHASE_AABB_TREE:
+                tree.QueryPairs([this](int proxyA, int proxyB) {
+                    const int a = tree.GetUserData(proxyA);
+                    const int b = tree.GetUserData(proxyB);
+
+                    if (colliderFilters[a].CanCollide(colliderFilters[b])) {
+                        candidatePairs.emplace_back(a, b);
+                    }
+                });
+                break;
+        }
+
+        const auto broadPhaseTime = std::chrono::steady_clock::now();
+
+        // Narrow phase: batched box tests produce the compact list of overlapping pairs,
+        // the brute force pairs are filtered by layer here, the other broad phases already did it
+        if (broadPhaseMode == BROAD_PHASE_BRUTE_FORCE) {
+            jobSystem->ParallelFor(colliderBoxes.size(), COLLISION_BOXES_PER_JOB, [this](std::size_t begin, std::size_t end) {
+                colliderBounds.FindAllOverlaps(begin, end, threadPairs[JobSystem::GetThreadIndex()]);
+            }, "CollisionSystem::NarrowPhase");
+        } else {
+            jobSystem->ParallelFor(candidatePairs.size(), COLLISION_PAIRS_PER_JOB, [this](std::size_t begin, std::size_t end) {
+                colliderBounds.FindOverlaps(candidatePairs, begin, end, threadPairs[JobSystem::GetThreadIndex()]);
+            }, "CollisionSystem::NarrowPhase");
+        }
+
+        // Sorting makes the events come out in the same order whatever thread found each pair
+        MergeThreadPairs(overlappingPairs);
+        std::sort(overlappingPairs.begin(), overlappingPairs.end());
+        overlappingPairs.erase(std::unique(overlappingPairs.begin(), overlappingPairs.end()), overlappingPairs.end());
+
+        const int numColliders = colliderBoxes.size();
+        stats.numColliders = numColliders;
+        stats.numCandidatePairs = broadPhaseMode == BROAD_PHASE_BRUTE_FORCE ? numColliders * (numColliders - 1) / 2 : candidatePairs.size();
+        stats.numCollisions = overlappingPairs.size();
+        stats.numTileContacts = tileContacts.size();
+
+        // Every contact goes to the frame contact list, only the few that start or end also go through the event bus
+        stats.numContactsEntered = 0;
+        stats.numContactsExited = 0;
+        contacts.clear();
+        contactCache.BeginFrame();
+
+        for (const auto& pair : overlappingPairs) {
+            Entity a = colliderEntities[pair.a];
+            Entity b = colliderEntities[pair.b];
+            if (b.GetId() < a.GetId()) {
+                std::swap(a, b);
+            }
+
+            if (contactCache.Touch(a, b)) {
+                Logger::Log("Entity " + std::to_string(a.GetId()) + " started colliding with " + std::to_string(b.GetId()));
+                eventBus->EmitEvent<CollisionEnterEvent>(a, b);
+                contacts.push_back(Contact { a, b, CONTACT_ENTER });
+                stats.numContactsEntered++;
+            } else {
+                contacts.push_back(Contact { a, b, CONTACT_STAY });
+            }
+        }
+
+        // Pairs come out in collider order, sorting by entity keeps the contacts of an entity together
+        std::sort(contacts.begin(), contacts.end(), [](const Contact& lhs, const Contact& rhs) {
+            return lhs.a.GetId() != rhs.a.GetId() ? lhs.a.GetId() < rhs.a.GetId() : lhs.b.GetId() < rhs.b.GetId();
+        });
+
+        contactCache.EndFrame([&](Entity a, Entity b) {
+            eventBus->EmitEvent<CollisionExitEvent>(a, b);
+            stats.numContactsExited++;
+        });
+
+        const auto endTime = std::chrono::steady_clock::now();
+        stats.treeUpdateMs = std::chrono::duration<double, std::milli>(treeUpdateTime - startTime).count();
+        stats.broadPhaseMs = std::chrono::duration<double, std::milli>(broadPhaseTime - treeUpdateTime).count();
+        stats.narrowPhaseMs = std::chrono::duration<double, std::milli>(endTime - broadPhaseTime).count();
+    }
+
+    // Appends the colliders overlapping the rectangle, with their boxes as of the last update
+    void QueryRect(const AABB& rect, std::vector<Entity>& result) {
+        if (isTreeDirty) {
+            UpdateTree();
+        }
+
+        tree.Query(rect, [&](int proxy) {
+            const int index = tree.GetUserData(proxy);
+            if (colliderBoxes[index].Overlaps(rect)) {
+                result.push_back(colliderEntities[index]);
+            }
+            return true;
+        });
     }
 
-    bool CheckAABBCollision(double aX, double aY, double aW, double aH, double bX, double bY, double bW, double bH) {
-        return (
-            aX < bX + bW &&
-            aX + aW > bX &&
-            aY < bY + bH &&
-            aY + aH > bY
-        );
+    // Returns the first collider crossed by the segment from origin to target, as of the last update
+    std::optional<RayCastHit> RayCast(glm::vec2 origin, glm::vec2 target) {
+        if (isTreeDirty) {
+            UpdateTree();
+        }
+
+        std::optional<RayCastHit> closestHit;
+        const glm::vec2 delta = target - origin;
+
+        tree.RayCast(origin, target, [&](int proxy, float maxFraction) {
+            const int index = tree.GetUserData(proxy);
+
+            float fraction;
+            if (!colliderBoxes[index].IntersectsSegment(origin, delta, maxFraction, fraction)) {
+                return maxFraction;
+            }
+
+            // Clip the segment at the hit, only closer colliders are tested from now on
+            closestHit = RayCastHit { colliderEntities[index], origin + fraction * delta, fraction };
+            return fraction;
+        });
+
+        return closestHit;
     }
 };
-#endif
\ No newline at end of file
+#endif
@@ -5,42 +5,36 @@
 #include "../Components/BoxColliderComponent.h"
 #include "../Components/ProjectileComponent.h"
 #include "../Components/HealthComponent.h"
-#include "../EventBus/EventBus.h"
-#include "../Event/CollisionEvent.h"
+#include "../Physics/ContactCache.h"
 #include "../Logger/Logger.h"
 
 class DamageSystem : public System {
 public:
     DamageSystem()  {
-        RequireComponent<BoxColliderComponent>();
+        RequireComponent<BoxColliderComponent>(ACCESS_READ);
+        UseComponent<ProjectileComponent>(ACCESS_READ);
+        UseComponent<HealthComponent>(ACCESS_WRITE);
     }
 
-    void SubscribeToEvents(std::unique_ptr<EventBus>& eventBus) {
-        eventBus->SubscribeToEvent<CollisionEvent>(this, &DamageSystem::onCollision);
-    }
-
-    void onCollision(CollisionEvent& event) {
-        // testing bullet spawning
-        Entity a = event.a;
-        Entity b = event.b;
-        
-        Logger::Log("The Damage system received an event collision between entities: " + 
-            std::to_string(a.GetId()) + " and " + std::to_string(b.GetId()));
+    void OnCollision(Entity a, Entity b) {
+        // Names are hashed at compile time, the checks below only compare integers and bits
+        static constexpr NameId PROJECTILES("projectiles");
+        static constexpr NameId ENEMIES("enemies");
+        static constexpr NameId PLAYER("player");
 
-    
-        if (a.BelongsToGroup("projectiles") && b.HasTag("player")) {
+        if (a.BelongsToGroup(PROJECTILES) && b.HasTag(PLAYER)) {
             OnProjectileHitsPlayer(a, b); // a projectile, b player
         }
 
-        if (b.BelongsToGroup("projectiles") && a.HasTag("player")) {
+        if (b.BelongsToGroup(PROJECTILES) && a.HasTag(PLAYER)) {
             OnProjectileHitsPlayer(b, a); // b projectile, a player
         }
 
-        if (a.BelongsToGroup("projectiles") && b.BelongsToGroup("enemies")) {
+        if (a.BelongsToGroup(PROJECTILES) && b.BelongsToGroup(ENEMIES)) {
             OnProjectileHitsEnemy(a, b);
         }
 
-        if (b.BelongsToGroup("projectiles") && a.BelongsToGroup("enemies")) {
+        if (b.BelongsToGroup(PROJECTILES) && a.BelongsToGroup(ENEMIES)) {
             OnProjectileHitsEnemy(b, a);
         }
     }
@@ -80,7 +74,14 @@ public:
         }
     }
 
-    void Update() {}
+    // Walks the contact list of the collision system, damage is dealt once when the projectile starts touching its target
+    void Update(const std::vector<Contact>& contacts) {
+        for (const auto& contact : contacts) {
+            if (contact.state == CONTACT_ENTER) {
+                OnCollision(contact.a, contact.b);
+            }
+        }
+    }
 };
 
 #endif
\ No newline at end of file
@@ -2,31 +2,25 @@
 #define MOVEMENTSYSTEM_H
 
 #include "../ECS/ECS.h"
+#include "../JobSystem/JobSystem.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/RigidBodyComponent.h"
-#include "../Logger/Logger.h"
 
 class MovementSystem : public System {
 
 public:
     MovementSystem() {
         RequireComponent<TransformComponent>();
-        RequireComponent<RigidBodyComponent>();
+        RequireComponent<RigidBodyComponent>(ACCESS_READ);
     }
 
-    void Update(double deltatime) {
-        for (auto entity : GetSystemEntities()) {
-            auto& transform = entity.GetComponent<TransformComponent>();
-            const auto rigidbody = entity.GetComponent<RigidBodyComponent>();
-
-            transform.position.x += rigidbody.velocity.x * deltatime;
-            transform.position.y += rigidbody.velocity.y * deltatime;
-
-            Logger::Log("Entity id = " + std::to_string(
-                entity.GetId()) + " position is now (" + 
-                std::to_string(transform.position.x) + ", " + 
-                std::to_string(transform.position.y) + ")");
-        }
+    void Update(std::unique_ptr<Registry>& registry, std::unique_ptr<JobSystem>& jobSystem, double deltatime) {
+        // No logging in the loop body, the logger serializes on a mutex and would make the workers run in lock-step
+        jobSystem->ParallelForEach(registry->View<TransformComponent, RigidBodyComponent>(),
+            [deltatime](Entity, TransformComponent& transform, const RigidBodyComponent& rigidbody) {
+                transform.position.x += rigidbody.velocity.x * deltatime;
+                transform.position.y += rigidbody.velocity.y * deltatime;
+            }, "MovementSystem");
     }
 };
 
@@ -16,8 +16,10 @@
 class ProjectileEmitSystem : public System {
 public:
     ProjectileEmitSystem() {
-        RequireComponent<TransformComponent>();
+        RequireComponent<TransformComponent>(ACCESS_READ);
         RequireComponent<ProjectileEmitterComponent>();
+        UseComponent<SpriteComponent>(ACCESS_READ);
+        UseComponent<RigidBodyComponent>(ACCESS_READ);
     }
 
     void SubscribeToEvents(std::unique_ptr<EventBus>& eventBus) {
@@ -53,16 +55,18 @@ public:
                     projectileVelocity.x = projectileEmitter.projectileVelocity.x * directionX;
                     projectileVelocity.y = projectileEmitter.projectileVelocity.y * directionY;
 
-                    // Create new projectile entity and add it to the world
-                    Entity projectile = entity.registry->CreateEntity();
-                    projectile.Group("projectiles");
-                    projectile.AddComponent<TransformComponent>(projectilePosition, glm::vec2(1.0, 1.0), 0.0);
-                    projectile.AddComponent<RigidBodyComponent>(projectileVelocity);
-                    projectile.AddComponent<SpriteComponent>("bullet-image", 4, 4, 4);
-                    projectile.AddComponent<BoxColliderComponent>(4, 4);
-                    projectile.AddComponent<ProjectileComponent>(projectileEmitter.isFriendly,
-                                                                 projectileEmitter.hitPercentDamage,
-                                                                 projectileEmitter.projectileDuration);
+                    // Create new projectile entity, it's added to the world on the next registry update
+                    CommandBuffer& commandBuffer = entity.registry->GetCommandBuffer();
+                    Entity projectile = commandBuffer.CreateEntity();
+                    commandBuffer.Group(projectile, "projectiles");
+                    commandBuffer.AddComponent<TransformComponent>(projectile, projectilePosition, glm::vec2(1.0, 1.0), 0.0);
+                    commandBuffer.AddComponent<RigidBodyComponent>(projectile, projectileVelocity);
+                    commandBuffer.AddComponent<SpriteComponent>(projectile, "bullet-image", 4, 4, 4);
+                    commandBuffer.AddComponent<BoxColliderComponent>(projectile, 4, 4, glm::vec2(0),
+                                                                     projectileEmitter.isFriendly ? LAYER_PLAYER_PROJECTILE : LAYER_ENEMY_PROJECTILE);
+                    commandBuffer.AddComponent<ProjectileComponent>(projectile, projectileEmitter.isFriendly,
+                                                                    projectileEmitter.hitPercentDamage,
+                                                                    projectileEmitter.projectileDuration);
 
                 }
             }
@@ -70,6 +74,9 @@ public:
     }
 
     void Update(std::unique_ptr<Registry>& registry) {
+        // Projectiles are recorded in the command buffer, so this system can run on a worker thread
+        CommandBuffer& commandBuffer = registry->GetCommandBuffer();
+
         for (auto entity : GetSystemEntities()) {
             const auto transform = entity.GetComponent<TransformComponent>();
             auto& projectileEmitter = entity.GetComponent<ProjectileEmitterComponent>();
@@ -90,15 +97,16 @@ public:
                     projectilePosition.y += (transform.scale.y * sprite.height/2);
                 }
                 
-                Entity projectile = registry->CreateEntity();
-                projectile.Group("projectiles");
-                projectile.AddComponent<TransformComponent>(projectilePosition, glm::vec2(1.0,1.0), 0.0);
-                projectile.AddComponent<RigidBodyComponent>(projectileEmitter.projectileVelocity);
-                projectile.AddComponent<SpriteComponent>("bullet-image", 4, 4, 4);
-                projectile.AddComponent<BoxColliderComponent>(4, 4);
-                projectile.AddComponent<ProjectileComponent>(projectileEmitter.isFriendly, 
-                                                             projectileEmitter.hitPercentDamage,
-                                                             projectileEmitter.projectileDuration);
+                Entity projectile = commandBuffer.CreateEntity();
+                commandBuffer.Group(projectile, "projectiles");
+                commandBuffer.AddComponent<TransformComponent>(projectile, projectilePosition, glm::vec2(1.0,1.0), 0.0);
+                commandBuffer.AddComponent<RigidBodyComponent>(projectile, projectileEmitter.projectileVelocity);
+                commandBuffer.AddComponent<SpriteComponent>(projectile, "bullet-image", 4, 4, 4);
+                commandBuffer.AddComponent<BoxColliderComponent>(projectile, 4, 4, glm::vec2(0),
+                                                                 projectileEmitter.isFriendly ? LAYER_PLAYER_PROJECTILE : LAYER_ENEMY_PROJECTILE);
+                commandBuffer.AddComponent<ProjectileComponent>(projectile, projectileEmitter.isFriendly, 
+                                                                projectileEmitter.hitPercentDamage,
+                                                                projectileEmitter.projectileDuration);
 
                 projectileEmitter.lastEmissionTime = SDL_GetTicks();
             }
@@ -8,7 +8,7 @@
 class ProjectileLifecycleSystem : public System {
 public:
     ProjectileLifecycleSystem() {
-        RequireComponent<ProjectileComponent>();
+        RequireComponent<ProjectileComponent>(ACCESS_READ);
     }
 
     void Update() {
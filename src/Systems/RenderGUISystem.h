@@ -10,12 +10,15 @@
 #include "../Components/BoxColliderComponent.h"
 #include "../Components/ProjectileEmitterComponent.h"
 #include "../Components/HealthComponent.h"
+#include "CollisionSystem.h"
+#include "RenderSystem.h"
+#include "RenderTilemapSystem.h"
 
 class RenderGUISystem : public System {
 public:
     RenderGUISystem() = default;
 
-    void Update(const std::unique_ptr<Registry>& registry, const SDL_Rect& camera) {
+    void Update(const std::unique_ptr<Registry>& registry, std::unique_ptr<AssetStore>& assetStore, const SDL_Rect& camera) {
         // TODO: draw all the ImGui objects in the screen
         ImGui::NewFrame();
 
@@ -88,7 +91,7 @@ public:
                 enemy.AddComponent<TransformComponent>(glm::vec2(posX, posY), glm::vec2(scaleX, scaleY), glm::degrees(rotation));
                 enemy.AddComponent<RigidBodyComponent>(glm::vec2(velX, velY));
                 enemy.AddComponent<SpriteComponent>(sprites[selectedSpriteIndex], 32, 32, 2);
-                enemy.AddComponent<BoxColliderComponent>(32, 32, glm::vec2(5,5));
+                enemy.AddComponent<BoxColliderComponent>(32, 32, glm::vec2(5,5), LAYER_ENEMY);
                 double projVelX = cos(projAngle) * projSpeed;
                 double projVelY = sin(projAngle) * projSpeed;
                 enemy.AddComponent<ProjectileEmitterComponent>(glm::vec2(projVelX, projVelY), projRepeat * 1000, projDuration * 1000, 10, false);
@@ -117,6 +120,53 @@ public:
             );
         }
 
+        ImGui::End();
+
+        // collision broad phase switch and the counters of the last frame
+        if (ImGui::Begin("Collision")) {
+            auto& collisionSystem = registry->GetSystem<CollisionSystem>();
+            const char* broadPhases[] = {"brute force", "uniform grid", "sweep and prune", "aabb tree"};
+            int broadPhase = collisionSystem.GetBroadPhase();
+
+            if (ImGui::Combo("broad phase", &broadPhase, broadPhases, IM_ARRAYSIZE(broadPhases))) {
+                collisionSystem.SetBroadPhase(static_cast<BroadPhaseMode>(broadPhase));
+            }
+
+            const auto& stats = collisionSystem.GetStats();
+            ImGui::Text("colliders: %d", stats.numColliders);
+            ImGui::Text("candidate pairs: %d", stats.numCandidatePairs);
+            ImGui::Text("collisions: %d (%d entered, %d exited)", stats.numCollisions, stats.numContactsEntered, stats.numContactsExited);
+            ImGui::Text("tile contacts: %d", stats.numTileContacts);
+            ImGui::Text("tree update: %.3f ms", stats.treeUpdateMs);
+            ImGui::Text("broad phase: %.3f ms", stats.broadPhaseMs);
+            ImGui::Text("narrow phase: %.3f ms", stats.narrowPhaseMs);
+        }
+
+        ImGui::End();
+
+        // sprites drawn and culled by the camera in the last frame
+        if (ImGui::Begin("Render")) {
+            auto& renderSystem = registry->GetSystem<RenderSystem>();
+            bool isBatchingEnabled = renderSystem.IsBatchingEnabled();
+
+            if (ImGui::Checkbox("batch sprites", &isBatchingEnabled)) {
+                renderSystem.SetBatchingEnabled(isBatchingEnabled);
+            }
+
+            const auto& stats = renderSystem.GetStats();
+            ImGui::Text("sprites: %d", stats.numSprites);
+            ImGui::Text("culled: %d", stats.numCulled);
+            ImGui::Text("drawn: %d", stats.numDrawn);
+            ImGui::Text("draw calls: %d (largest batch %d)", stats.numDrawCalls, stats.maxBatchSize);
+
+            const auto& tilemapStats = registry->GetSystem<RenderTilemapSystem>().GetStats();
+            ImGui::Text("tilemap chunks: %d of %d drawn", tilemapStats.numChunksDrawn, tilemapStats.numChunks);
+
+            const auto& textStats = assetStore->GetTextCache().GetStats();
+            ImGui::Text("text labels: %d (%zu bytes)", textStats.numLabels, textStats.numBytes);
+            ImGui::Text("text hits: %d, misses: %d, evictions: %d", textStats.numHits, textStats.numMisses, textStats.numEvictions);
+        }
+
         ImGui::End();
         ImGui::Render();
         ImGuiSDL::Render(ImGui::GetDrawData());
@@ -55,24 +55,15 @@ class RenderHealthBarSystem: public System {
                 SDL_SetRenderDrawColor(renderer, healthBarColor.r, healthBarColor.g, healthBarColor.b, 255);
                 SDL_RenderFillRect(renderer, &healthBarRectangle);
 
-                // render the health percentage text label indicator
+                // render the health percentage text label indicator, it changes often so it is drawn from the glyph atlas
                 std::string healthText = std::to_string(health.healthPercentage);
-                SDL_Surface* surface = TTF_RenderText_Blended(assetStore->GetFont("pico8-font-5"), healthText.c_str(), healthBarColor);
-                SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-                SDL_FreeSurface(surface);
-
-                int labelWidth = 0;
-                int labelHeight = 0;
-                SDL_QueryTexture(texture, NULL, NULL, &labelWidth, &labelHeight);
-                SDL_Rect healthBarTextRectangle = {
+                assetStore->GetTextCache().DrawGlyphs(
+                    renderer,
+                    assetStore->GetFont("pico8-font-5"),
+                    healthText,
+                    healthBarColor,
                     static_cast<int>(healthBarPosX),
-                    static_cast<int>(healthBarPosY) + 5,
-                    labelWidth,
-                    labelHeight
-                };
-
-                SDL_RenderCopy(renderer, texture, NULL, &healthBarTextRectangle);
-                SDL_DestroyTexture(texture);
+                    static_cast<int>(healthBarPosY) + 5);
             }
         }
 
@@ -6,61 +6,302 @@
 #include "../Components/TransformComponent.h"
 #include "../AssetStore/AssetStore.h"
 #include <SDL2/SDL.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+// SDL_RenderGeometry came with SDL 2.0.18, older versions draw every sprite with SDL_RenderCopyEx
+#define RENDER_HAS_GEOMETRY SDL_VERSION_ATLEAST(2, 0, 18)
+
+// Counters of the last frame, culled sprites are outside of the camera
+struct RenderStats {
+    int numSprites = 0;
+    int numCulled = 0;
+    int numDrawn = 0;
+    int numDrawCalls = 0;
+    int maxBatchSize = 0;
+};
+
+// Entry of the render queue, small enough to sort in place. The texture is looked up once, on the first
+// frame the sprite is drawn; a key with entityId -1 belongs to a removed sprite and is dropped on the next sort
+struct RenderKey {
+    int zIndex;
+    int entityId;
+    SDL_Texture* texture;
+};
 
 class RenderSystem : public System {
+private:
+    RenderStats stats;
+
+    // Sprites ordered by zIndex and then texture, kept from frame to frame and only reordered when it changes.
+    // Keys from numResolvedKeys on were added since the last update and have no texture yet
+    std::vector<RenderKey> renderQueue;
+    std::size_t numResolvedKeys = 0;
+    int numRemovedKeys = 0;
+    bool isQueueSorted = true;
+    Registry* registry = nullptr;
+
+    // Position of the key of every entity id in the queue (-1 if none), and where the image starts in its
+    // texture when it was packed in an atlas
+    std::vector<int> queueIndexPerId;
+    std::vector<SDL_Point> textureOffsetPerId;
+
+    // Consecutive sprites with the same texture and zIndex are drawn with a single SDL_RenderGeometry call
+    bool isBatchingEnabled = true;
+#if RENDER_HAS_GEOMETRY
+    std::vector<SDL_Vertex> batchVertices;
+    std::vector<int> batchIndices;
+    SDL_Texture* batchTexture = nullptr;
+    int batchZIndex = 0;
+    float batchTextureWidth = 1;
+    float batchTextureHeight = 1;
+
+    void FlushBatch(SDL_Renderer* renderer) {
+        if (batchIndices.empty()) {
+            return;
+        }
+
+        SDL_RenderGeometry(renderer, batchTexture, batchVertices.data(), batchVertices.size(), batchIndices.data(), batchIndices.size());
+        stats.numDrawCalls++;
+        stats.maxBatchSize = std::max(stats.maxBatchSize, static_cast<int>(batchVertices.size() / 4));
+
+        batchVertices.clear();
+        batchIndices.clear();
+    }
+
+    // Appends the two triangles of the sprite, the corners are turned around the center of the rect like SDL_RenderCopyEx does
+    void AddToBatch(SDL_Renderer* renderer, const RenderKey& key, const SDL_Rect& srcRect, const SDL_Rect& dstRect, double rotation) {
+        if (key.texture != batchTexture || key.zIndex != batchZIndex) {
+            FlushBatch(renderer);
+
+            int textureWidth = 1, textureHeight = 1;
+            SDL_QueryTexture(key.texture, NULL, NULL, &textureWidth, &textureHeight);
+            batchTexture = key.texture;
+            batchZIndex = key.zIndex;
+            batchTextureWidth = textureWidth;
+            batchTextureHeight = textureHeight;
+        }
+
+        const float halfWidth = dstRect.w * 0.5f;
+        const float halfHeight = dstRect.h * 0.5f;
+        const float centerX = dstRect.x + halfWidth;
+        const float centerY = dstRect.y + halfHeight;
+        const float radians = static_cast<float>(glm::radians(rotation));
+        const float cosine = rotation != 0.0 ? std::cos(radians) : 1.0f;
+        const float sine = rotation != 0.0 ? std::sin(radians) : 0.0f;
+
+        const float u0 = srcRect.x / batchTextureWidth;
+        const float v0 = srcRect.y / batchTextureHeight;
+        const float u1 = (srcRect.x + srcRect.w) / batchTextureWidth;
+        const float v1 = (srcRect.y + srcRect.h) / batchTextureHeight;
+
+        // Top left, top right, bottom right, bottom left
+        const float cornerX[4] = {-halfWidth, halfWidth, halfWidth, -halfWidth};
+        const float cornerY[4] = {-halfHeight, -halfHeight, halfHeight, halfHeight};
+        const float cornerU[4] = {u0, u1, u1, u0};
+        const float cornerV[4] = {v0, v0, v1, v1};
+
+        const int firstVertex = batchVertices.size();
+        for (int i = 0; i < 4; i++) {
+            SDL_Vertex vertex;
+            vertex.position.x = centerX + cornerX[i] * cosine - cornerY[i] * sine;
+            vertex.position.y = centerY + cornerX[i] * sine + cornerY[i] * cosine;
+            vertex.color = {255, 255, 255, 255};
+            vertex.tex_coord.x = cornerU[i];
+            vertex.tex_coord.y = cornerV[i];
+            batchVertices.push_back(vertex);
+        }
+
+        const int quadIndices[6] = {0, 1, 2, 2, 3, 0};
+        for (const int index : quadIndices) {
+            batchIndices.push_back(firstVertex + index);
+        }
+    }
+#endif
+
+    // Destination rect of the sprite on the screen
+    static SDL_Rect GetDstRect(const TransformComponent& transform, const SpriteComponent& sprite, const SDL_Rect& camera) {
+        return {
+            static_cast<int>(transform.position.x - (sprite.isFixed ? 0 : camera.x)),
+            static_cast<int>(transform.position.y - (sprite.isFixed ? 0 : camera.y)),
+            static_cast<int>(sprite.width * transform.scale.x),
+            static_cast<int>(sprite.height * transform.scale.y)
+        };
+    }
+
+    // Whether the rect touches the screen, a rotated rect is grown to the circle it turns in
+    static bool IsOnScreen(SDL_Rect dstRect, double rotation, const SDL_Rect& camera) {
+        if (rotation != 0.0) {
+            const int diagonal = static_cast<int>(std::ceil(std::sqrt(double(dstRect.w) * dstRect.w + double(dstRect.h) * dstRect.h)));
+            dstRect.x -= (diagonal - dstRect.w) / 2 + 1;
+            dstRect.y -= (diagonal - dstRect.h) / 2 + 1;
+            dstRect.w = diagonal + 2;
+            dstRect.h = diagonal + 2;
+        }
+
+        return dstRect.x < camera.w && dstRect.x + dstRect.w > 0 && dstRect.y < camera.h && dstRect.y + dstRect.h > 0;
+    }
+
+    static bool IsDrawnBefore(const RenderKey& a, const RenderKey& b) {
+        return a.zIndex < b.zIndex || (a.zIndex == b.zIndex && std::less<SDL_Texture*>()(a.texture, b.texture));
+    }
+
+    // Drops the keys of the removed sprites and sorts the rest. Insertion sort, the queue only gets a few
+    // new or changed keys per frame so it is almost sorted
+    void SortQueue() {
+        if (numRemovedKeys > 0) {
+            renderQueue.erase(std::remove_if(renderQueue.begin(), renderQueue.end(), [](const RenderKey& key) {
+                return key.entityId == -1;
+            }), renderQueue.end());
+            numRemovedKeys = 0;
+        }
+
+        for (std::size_t i = 1; i < renderQueue.size(); i++) {
+            const RenderKey key = renderQueue[i];
+            std::size_t j = i;
+
+            while (j > 0 && IsDrawnBefore(key, renderQueue[j - 1])) {
+                renderQueue[j] = renderQueue[j - 1];
+                j--;
+            }
+            renderQueue[j] = key;
+        }
+
+        for (std::size_t i = 0; i < renderQueue.size(); i++) {
+            queueIndexPerId[renderQueue[i].entityId] = i;
+        }
+
+        isQueueSorted = true;
+    }
+
 public:    
     RenderSystem() {
         RequireComponent<SpriteComponent>();
         RequireComponent<TransformComponent>();
     }
 
+    const RenderStats& GetStats() const { return stats; }
+
+    void SetBatchingEnabled(bool enabled) { isBatchingEnabled = enabled; }
+    bool IsBatchingEnabled() const { return isBatchingEnabled; }
+
+    void OnEntityAdded(Entity entity) override {
+        const std::size_t entityId = entity.GetId();
+        if (entityId >= queueIndexPerId.size()) {
+            queueIndexPerId.resize(entityId + 1, -1);
+            textureOffsetPerId.resize(entityId + 1);
+        }
+
+        registry = entity.registry;
+        queueIndexPerId[entityId] = renderQueue.size();
+        renderQueue.push_back(RenderKey { entity.GetComponent<SpriteComponent>().zIndex, entity.GetId(), nullptr });
+        isQueueSorted = false;
+    }
+
+    void OnEntityRemoved(Entity entity) override {
+        // The key is only marked, the next sort drops it with the others removed in the frame
+        int& queueIndex = queueIndexPerId[entity.GetId()];
+        renderQueue[queueIndex].entityId = -1;
+        queueIndex = -1;
+        numRemovedKeys++;
+        isQueueSorted = false;
+    }
+
+    // A new SpriteComponent can have another image and zIndex, the key is built again from it
+    void OnEntityChanged(Entity entity) override {
+        OnEntityRemoved(entity);
+        OnEntityAdded(entity);
+    }
+
+    // Changes the draw order of a sprite in the queue. Entities that are not in the system yet don't need it,
+    // their key takes the zIndex of the SpriteComponent when they are added
+    void SetZIndex(Entity entity, int zIndex) {
+        const std::size_t entityId = entity.GetId();
+        if (entityId >= queueIndexPerId.size() || queueIndexPerId[entityId] == -1) {
+            return;
+        }
+
+        entity.GetComponent<SpriteComponent>().zIndex = zIndex;
+
+        const int queueIndex = queueIndexPerId[entityId];
+        if (renderQueue[queueIndex].zIndex != zIndex) {
+            renderQueue[queueIndex].zIndex = zIndex;
+            isQueueSorted = false;
+        }
+    }
+
     void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, SDL_Rect& camera) {
-        // Create a vector with both Sprite and Transform component of all entities
-        struct RendableEntity {
-            TransformComponent transformComponent;
-            SpriteComponent spriteComponent;
-        };
-        
-        std::vector<RendableEntity> rendableEntities; 
-        
-        for (auto entity : GetSystemEntities()) {
-            RendableEntity rendableEntity;
-            rendableEntity.transformComponent = entity.GetComponent<TransformComponent>();
-            rendableEntity.spriteComponent = entity.GetComponent<SpriteComponent>();
-            rendableEntities.emplace_back(rendableEntity);
+        // Look up the textures of the sprites added since the last update
+        for (std::size_t i = numResolvedKeys; i < renderQueue.size(); i++) {
+            RenderKey& key = renderQueue[i];
+            if (key.entityId == -1) {
+                continue;
+            }
+
+            const auto& sprite = registry->GetEntity(key.entityId).GetComponent<SpriteComponent>();
+            const SDL_Rect& textureRect = assetStore->GetTextureRect(sprite.assetId);
+            key.texture = assetStore->GetTexture(sprite.assetId);
+            textureOffsetPerId[key.entityId] = {textureRect.x, textureRect.y};
         }
 
-        // Sort Vector
-        std::sort(rendableEntities.begin(), rendableEntities.end(), 
-        [](const RendableEntity& a, const RendableEntity& b) {
-            return a.spriteComponent.zIndex < b.spriteComponent.zIndex; 
-        });
+        if (!isQueueSorted) {
+            SortQueue();
+        }
+        numResolvedKeys = renderQueue.size();
 
-        for (auto entity : rendableEntities) {
-            const auto transform = entity.transformComponent;
-            const auto sprite = entity.spriteComponent;
+        stats = RenderStats();
+        stats.numSprites = renderQueue.size();
 
-            // Define the portion of the sprite texture to render
-            SDL_Rect srcRect = sprite.srcRect;
+        for (const auto& key : renderQueue) {
+            const Entity entity = registry->GetEntity(key.entityId);
+            const auto& transform = entity.GetComponent<TransformComponent>();
+            const auto& sprite = entity.GetComponent<SpriteComponent>();
+            assert(sprite.zIndex == key.zIndex && "The zIndex of a drawn sprite has to be changed with RenderSystem::SetZIndex");
 
             // Define the position and size of the sprite on the screen
-            SDL_Rect dstRect = {
-                static_cast<int>(transform.position.x - (sprite.isFixed ? 0 : camera.x)),
-                static_cast<int>(transform.position.y - (sprite.isFixed ? 0 : camera.y)),
-                static_cast<int>(sprite.width * transform.scale.x),
-                static_cast<int>(sprite.height * transform.scale.y)
-            };
+            SDL_Rect dstRect = GetDstRect(transform, sprite, camera);
+
+            // Fixed sprites are in screen coordinates and always drawn
+            if (!sprite.isFixed && !IsOnScreen(dstRect, transform.rotation, camera)) {
+                stats.numCulled++;
+                continue;
+            }
+
+            // Define the portion of the sprite texture to render, the source rect is relative to the image
+            SDL_Rect srcRect = sprite.srcRect;
+            srcRect.x += textureOffsetPerId[key.entityId].x;
+            srcRect.y += textureOffsetPerId[key.entityId].y;
+
+#if RENDER_HAS_GEOMETRY
+            if (isBatchingEnabled) {
+                AddToBatch(renderer, key, srcRect, dstRect, transform.rotation);
+                stats.numDrawn++;
+                continue;
+            }
+#endif
 
             // Renders the texture with rotation, scaling, and flipping options
             SDL_RenderCopyEx(
                 renderer, 
-                assetStore->GetTexture(sprite.assetId),
+                key.texture,
                 &srcRect,
                 &dstRect,
                 transform.rotation,
                 NULL,
                 SDL_FLIP_NONE);
+
+            stats.numDrawCalls++;
+            stats.maxBatchSize = 1;
+            stats.numDrawn++;
         }
+
+#if RENDER_HAS_GEOMETRY
+        FlushBatch(renderer);
+        batchTexture = nullptr;
+#endif
     }
 };
 
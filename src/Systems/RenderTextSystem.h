@@ -3,6 +3,7 @@
 
 #include "../ECS/ECS.h"
 #include "../Components/TextLabelComponent.h"
+#include "../AssetStore/AssetStore.h"
 #include <SDL2/SDL.h>
 
 class RenderTextSystem: public System {
@@ -13,20 +14,19 @@ class RenderTextSystem: public System {
 
         void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const SDL_Rect camera) {
             for (auto entity : GetSystemEntities()) {
-                const auto textlabel = entity.GetComponent<TextLabelComponent>();
+                const auto& textlabel = entity.GetComponent<TextLabelComponent>();
                 
-                SDL_Surface* surface = TTF_RenderText_Blended(
-                    assetStore->GetFont(textlabel.assetId), 
-                    textlabel.text.c_str(), 
-                    textlabel.color);
-
-                SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-                SDL_FreeSurface(surface);
-
+                // The texture is rendered once and reused while the label doesn't change
                 int labelWidth = 0;
                 int labelHeight = 0;
 
-                SDL_QueryTexture(texture, NULL, NULL, &labelWidth, &labelHeight);
+                SDL_Texture* texture = assetStore->GetTextCache().GetLabel(
+                    renderer,
+                    assetStore->GetFont(textlabel.assetId), 
+                    textlabel.text, 
+                    textlabel.color,
+                    labelWidth,
+                    labelHeight);
 
                 SDL_Rect dstRect = {
                     static_cast<int>(textlabel.position.x - (textlabel.isFixed ? 0 : camera.x)), 
@@ -36,7 +36,6 @@ class RenderTextSystem: public System {
                 };
 
                 SDL_RenderCopy(renderer, texture, NULL, &dstRect);
-                SDL_DestroyTexture(texture);
             }
         }
 };
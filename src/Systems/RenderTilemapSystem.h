@@ -0,0 +1,171 @@
+#ifndef RENDERTILEMAPSYSTEM_H
+#define RENDERTILEMAPSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TilemapComponent.h"
+#include "../AssetStore/AssetStore.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+// Number of tiles on each side of a baked chunk
+const int TILEMAP_CHUNK_SIZE = 16;
+
+// Counters of the last frame
+struct TilemapStats {
+    int numChunks = 0;
+    int numChunksDrawn = 0;
+};
+
+// Draws the tilemaps from chunks of TILEMAP_CHUNK_SIZE x TILEMAP_CHUNK_SIZE tiles baked into render target
+// textures, so a frame costs one copy per visible chunk instead of one per tile.
+// Chunks are baked the first time they are drawn, the tilemap is drawn under every sprite.
+class RenderTilemapSystem : public System {
+private:
+    struct BakedTilemap {
+        int numChunkCols = 0;
+        int numChunkRows = 0;
+        std::vector<SDL_Texture*> chunks;
+    };
+
+    std::unordered_map<int, BakedTilemap> bakedTilemaps;
+    TilemapStats stats;
+
+    static void DestroyChunks(BakedTilemap& baked) {
+        for (auto& chunk : baked.chunks) {
+            if (chunk) {
+                SDL_DestroyTexture(chunk);
+                chunk = nullptr;
+            }
+        }
+    }
+
+    // Renders the tiles of one chunk into a new texture, at the tileset resolution
+    static SDL_Texture* BakeChunk(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const TilemapComponent& tilemap, int chunkCol, int chunkRow) {
+        const int firstCol = chunkCol * TILEMAP_CHUNK_SIZE;
+        const int firstRow = chunkRow * TILEMAP_CHUNK_SIZE;
+        const int numCols = std::min(TILEMAP_CHUNK_SIZE, tilemap.numCols - firstCol);
+        const int numRows = std::min(TILEMAP_CHUNK_SIZE, tilemap.numRows - firstRow);
+
+        SDL_Texture* chunk = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, numCols * tilemap.tileSize, numRows * tilemap.tileSize);
+        if (!chunk) {
+            return nullptr;
+        }
+        SDL_SetTextureBlendMode(chunk, SDL_BLENDMODE_BLEND);
+
+        SDL_Texture* tileset = assetStore->GetTexture(tilemap.assetId);
+        const SDL_Rect& tilesetRect = assetStore->GetTextureRect(tilemap.assetId);
+
+        SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+        Uint8 r, g, b, a;
+        SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+
+        SDL_SetRenderTarget(renderer, chunk);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+        SDL_RenderClear(renderer);
+
+        for (int row = 0; row < numRows; row++) {
+            for (int col = 0; col < numCols; col++) {
+                const std::size_t index = (firstRow + row) * tilemap.numCols + firstCol + col;
+                if (index >= tilemap.tiles.size()) {
+                    continue;
+                }
+
+                const SDL_Point& tile = tilemap.tiles[index];
+                SDL_Rect srcRect = {tilesetRect.x + tile.x, tilesetRect.y + tile.y, tilemap.tileSize, tilemap.tileSize};
+                SDL_Rect dstRect = {col * tilemap.tileSize, row * tilemap.tileSize, tilemap.tileSize, tilemap.tileSize};
+                SDL_RenderCopy(renderer, tileset, &srcRect, &dstRect);
+            }
+        }
+
+        SDL_SetRenderTarget(renderer, previousTarget);
+        SDL_SetRenderDrawColor(renderer, r, g, b, a);
+
+        return chunk;
+    }
+
+public:
+    RenderTilemapSystem() {
+        RequireComponent<TilemapComponent>();
+    }
+
+    ~RenderTilemapSystem() {
+        for (auto& baked : bakedTilemaps) {
+            DestroyChunks(baked.second);
+        }
+    }
+
+    const TilemapStats& GetStats() const { return stats; }
+
+    void OnEntityAdded(Entity entity) override {
+        const auto& tilemap = entity.GetComponent<TilemapComponent>();
+        BakedTilemap& baked = bakedTilemaps[entity.GetId()];
+
+        DestroyChunks(baked);
+        baked.numChunkCols = (tilemap.numCols + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+        baked.numChunkRows = (tilemap.numRows + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+        baked.chunks.assign(baked.numChunkCols * baked.numChunkRows, nullptr);
+    }
+
+    void OnEntityRemoved(Entity entity) override {
+        auto baked = bakedTilemaps.find(entity.GetId());
+        if (baked != bakedTilemaps.end()) {
+            DestroyChunks(baked->second);
+            bakedTilemaps.erase(baked);
+        }
+    }
+
+    // Drops the baked chunks, they are baked again when drawn. Render targets lose their content when the
+    // renderer resets them
+    void InvalidateChunks() {
+        for (auto& baked : bakedTilemaps) {
+            DestroyChunks(baked.second);
+        }
+    }
+
+    void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const SDL_Rect& camera) {
+        stats = TilemapStats();
+
+        for (auto entity : GetSystemEntities()) {
+            const auto& tilemap = entity.GetComponent<TilemapComponent>();
+            BakedTilemap& baked = bakedTilemaps[entity.GetId()];
+            stats.numChunks += baked.chunks.size();
+
+            // Only the chunks under the camera are drawn
+            const double chunkSize = TILEMAP_CHUNK_SIZE * tilemap.tileSize * tilemap.tileScale;
+            if (chunkSize <= 0) {
+                continue;
+            }
+
+            const int firstChunkCol = std::max(static_cast<int>(std::floor(camera.x / chunkSize)), 0);
+            const int firstChunkRow = std::max(static_cast<int>(std::floor(camera.y / chunkSize)), 0);
+            const int lastChunkCol = std::min(static_cast<int>(std::floor((camera.x + camera.w) / chunkSize)), baked.numChunkCols - 1);
+            const int lastChunkRow = std::min(static_cast<int>(std::floor((camera.y + camera.h) / chunkSize)), baked.numChunkRows - 1);
+
+            for (int chunkRow = firstChunkRow; chunkRow <= lastChunkRow; chunkRow++) {
+                for (int chunkCol = firstChunkCol; chunkCol <= lastChunkCol; chunkCol++) {
+                    SDL_Texture*& chunk = baked.chunks[chunkRow * baked.numChunkCols + chunkCol];
+                    if (!chunk) {
+                        chunk = BakeChunk(renderer, assetStore, tilemap, chunkCol, chunkRow);
+                    }
+
+                    // Edges are rounded the same way for every chunk so neighbours never leave a gap
+                    const int left = static_cast<int>(chunkCol * chunkSize) - camera.x;
+                    const int top = static_cast<int>(chunkRow * chunkSize) - camera.y;
+                    const int numCols = std::min(TILEMAP_CHUNK_SIZE, tilemap.numCols - chunkCol * TILEMAP_CHUNK_SIZE);
+                    const int numRows = std::min(TILEMAP_CHUNK_SIZE, tilemap.numRows - chunkRow * TILEMAP_CHUNK_SIZE);
+                    const int right = static_cast<int>((chunkCol * TILEMAP_CHUNK_SIZE + numCols) * tilemap.tileSize * tilemap.tileScale) - camera.x;
+                    const int bottom = static_cast<int>((chunkRow * TILEMAP_CHUNK_SIZE + numRows) * tilemap.tileSize * tilemap.tileScale) - camera.y;
+
+                    SDL_Rect dstRect = {left, top, right - left, bottom - top};
+                    SDL_RenderCopy(renderer, chunk, NULL, &dstRect);
+                    stats.numChunksDrawn++;
+                }
+            }
+        }
+    }
+};
+
+#endif